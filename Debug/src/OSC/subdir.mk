@@ -10,17 +10,20 @@ CPP_SRCS += \
 ../src/OSC/SimpleWriter.cpp 
 
 C_SRCS += \
-../src/OSC/OSCMatch.c 
+../src/OSC/OSCMatch.c \
+../src/OSC/OSCPool.c 
 
 OBJS += \
 ./src/OSC/OSCData.o \
 ./src/OSC/OSCMatch.o \
 ./src/OSC/OSCMessage.o \
+./src/OSC/OSCPool.o \
 ./src/OSC/OSCTiming.o \
 ./src/OSC/SimpleWriter.o 
 
 C_DEPS += \
-./src/OSC/OSCMatch.d 
+./src/OSC/OSCMatch.d \
+./src/OSC/OSCPool.d 
 
 CPP_DEPS += \
 ./src/OSC/OSCData.d \
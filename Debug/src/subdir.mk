@@ -10,27 +10,57 @@ CPP_SRCS += \
 C_SRCS += \
 ../src/BlinkLed.c \
 ../src/Timer.c \
+../src/config.c \
+../src/curves.c \
+../src/frametime.c \
+../src/latency.c \
+../src/loopprof.c \
+../src/memstats.c \
 ../src/midi.c \
+../src/midiclock.c \
+../src/sched.c \
 ../src/spi.c \
 ../src/ssd1306.c \
+../src/sysex.c \
+../src/timesync.c \
 ../src/uart.c 
 
 OBJS += \
 ./src/BlinkLed.o \
 ./src/SLIPEncodedSerial.o \
 ./src/Timer.o \
+./src/config.o \
+./src/curves.o \
+./src/frametime.o \
+./src/latency.o \
+./src/loopprof.o \
 ./src/main.o \
+./src/memstats.o \
 ./src/midi.o \
+./src/midiclock.o \
+./src/sched.o \
 ./src/spi.o \
 ./src/ssd1306.o \
+./src/sysex.o \
+./src/timesync.o \
 ./src/uart.o 
 
 C_DEPS += \
 ./src/BlinkLed.d \
 ./src/Timer.d \
+./src/config.d \
+./src/curves.d \
+./src/frametime.d \
+./src/latency.d \
+./src/loopprof.d \
+./src/memstats.d \
 ./src/midi.d \
+./src/midiclock.d \
+./src/sched.d \
 ./src/spi.d \
 ./src/ssd1306.d \
+./src/sysex.d \
+./src/timesync.d \
 ./src/uart.d 
 
 CPP_DEPS += \
@@ -16,7 +16,7 @@ OSCData::OSCData(const char * s){
 	type = 's';
 	bytes = (strlen(s) + 1);
 	//own the data
-	char * mem = (char *) malloc(bytes);
+	char * mem = (char *) osc_pool_alloc(bytes);
 	if (mem == NULL){
 		error = ALLOCFAILED;
 	} else {
@@ -34,12 +34,14 @@ OSCData::OSCData(int32_t i){
 	bytes = 4;
 	data.i = i;
 }
+#ifndef OSC_INT32_IS_INT
 OSCData::OSCData(int i){
 	error = OSC_OK;
 	type = 'i';
 	bytes = 4;
 	data.i = i;
 }
+#endif
 OSCData::OSCData(unsigned int i){
 	error = OSC_OK;
 	type = 'i';
@@ -101,7 +103,7 @@ OSCData::OSCData(uint8_t * b, int len){
 	if(bytes>0)
     {
             
-        uint8_t * mem = (uint8_t * ) malloc(bytes);
+        uint8_t * mem = (uint8_t * ) osc_pool_alloc(bytes);
         if (mem == NULL){
             error = ALLOCFAILED;
         } else {
@@ -127,7 +129,7 @@ OSCData::OSCData (OSCData * datum){
 		data = datum->data;
 	} else if ((type == 's') || (type == 'b')){
 		//allocate a new piece of memory
-        uint8_t * mem = (uint8_t * ) malloc(bytes);
+        uint8_t * mem = (uint8_t * ) osc_pool_alloc(bytes);
         if (mem == NULL){
             error = ALLOCFAILED;
         } else {
@@ -144,9 +146,9 @@ OSCData::~OSCData(){
     if (bytes>0){
         //if the data is of type 's' or 'b', need to free that memory
         if (type == 's'){
-            free(data.s);
+            osc_pool_free(data.s);
         }else if( type == 'b'){
-            free(data.b);
+            osc_pool_free(data.b);
         }
     }
 }
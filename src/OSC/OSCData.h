@@ -34,6 +34,7 @@
 #include <string.h>
 
 #include "OSCTiming.h"
+#include "OSCPool.h"
 
 #if (defined(CORE_TEENSY) && defined(USB_SERIAL)) || (!defined(CORE_TEENSY) && defined(__AVR_ATmega32U4__)) || defined(__SAM3X8E__) || (defined(_USB) && defined(_USE_USB_FOR_SERIAL_)) || defined(BOARD_maple_mini)
 
@@ -86,13 +87,19 @@ public:
         osctime_t time;
 	} data;
 
+	//the objects and what they own come out of the OSC pools (OSCPool.h)
+	static void * operator new(size_t size) throw() { return osc_pool_alloc(size); }
+	static void operator delete(void * p) { osc_pool_free(p); }
+
 	//overload the constructor to account for all the types and sizes
 	OSCData(const char * s);
 #if defined(__SAM3X8E__)
 	OSCData (int16_t);
 #endif
 	OSCData (int32_t);
-    OSCData (int);
+#ifndef OSC_INT32_IS_INT
+    OSCData (int);    //int32_t is long on the part, the host builds (tests/) define this
+#endif
     OSCData (unsigned int);
 	OSCData (float);
 	OSCData (double);
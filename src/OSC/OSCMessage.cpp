@@ -78,11 +78,11 @@ void OSCMessage::setupMessage(){
 OSCMessage::~OSCMessage(){
 	//free everything that needs to be freed
     //free the address
-	free(address);
+	osc_pool_free(address);
     //free the data
     empty();
     //free the filling buffer
-    free(incomingBuffer);
+    osc_pool_free(incomingBuffer);
 }
 
 void OSCMessage::empty(){
@@ -95,7 +95,7 @@ void OSCMessage::empty(){
         delete datum;
     }
     //and free the array
-    free(data);
+    osc_pool_free(data);
     data = NULL;
     dataCount = 0;
     decodeState = STANDBY;
@@ -315,9 +315,9 @@ int OSCMessage::getAddress(char * buffer, int offset, int len){
 
 void OSCMessage::setAddress(const char * _address){
     //free the previous address
-    free(address); // are we sure address was allocated?
+    osc_pool_free(address); // are we sure address was allocated?
     //copy the address
-	char * addressMemory = (char *) malloc( (strlen(_address) + 1) * sizeof(char) );
+	char * addressMemory = (char *) osc_pool_alloc( (strlen(_address) + 1) * sizeof(char) );
 	if (addressMemory == NULL){
 		error = ALLOCFAILED;
 		address = NULL;
@@ -690,7 +690,7 @@ void OSCMessage::addToIncomingBuffer(uint8_t incomingByte){
     else
 	{
 
-        incomingBuffer = (uint8_t *) realloc ( incomingBuffer, incomingBufferSize + 1 + OSCPREALLOCATEIZE);
+        incomingBuffer = (uint8_t *) osc_pool_realloc( incomingBuffer, incomingBufferSize + 1 + OSCPREALLOCATEIZE);
         if (incomingBuffer != NULL){
             incomingBuffer[incomingBufferSize++] = incomingByte;
             incomingBufferFree = OSCPREALLOCATEIZE;
@@ -701,7 +701,7 @@ void OSCMessage::addToIncomingBuffer(uint8_t incomingByte){
 }
 
 void OSCMessage::clearIncomingBuffer(){
-    incomingBuffer = (uint8_t *) realloc ( incomingBuffer, OSCPREALLOCATEIZE);
+    incomingBuffer = (uint8_t *) osc_pool_realloc( incomingBuffer, OSCPREALLOCATEIZE);
 	if (incomingBuffer != NULL){
 		incomingBufferFree = OSCPREALLOCATEIZE;
 	} else {
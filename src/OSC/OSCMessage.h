@@ -140,7 +140,7 @@ public:
 			error = ALLOCFAILED;
 		} else {
 			//resize the data array
-			OSCData ** dataMem = (OSCData **) realloc(data, sizeof(OSCData *) * (dataCount + 1));
+			OSCData ** dataMem = (OSCData **) osc_pool_realloc(data, sizeof(OSCData *) * (dataCount + 1));
 			if (dataMem == NULL){
 				error = ALLOCFAILED;
 			} else {
@@ -163,7 +163,7 @@ public:
 			error = ALLOCFAILED;
 		} else {
 			//resize the data array
-			OSCData ** dataMem = (OSCData **) realloc(data, sizeof(OSCData *) * (dataCount + 1));
+			OSCData ** dataMem = (OSCData **) osc_pool_realloc(data, sizeof(OSCData *) * (dataCount + 1));
 			if (dataMem == NULL){
 				error = ALLOCFAILED;
 			} else {
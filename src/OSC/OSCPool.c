@@ -0,0 +1,133 @@
+/*
+ * OSCPool.c
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "OSCPool.h"
+
+// blocks are whole words so every block stays 8 byte aligned (OSCData has a double in it)
+static uint64_t pool_small[OSC_POOL_SMALL_COUNT][OSC_POOL_SMALL_SIZE / 8];
+static uint64_t pool_medium[OSC_POOL_MEDIUM_COUNT][OSC_POOL_MEDIUM_SIZE / 8];
+static uint64_t pool_large[OSC_POOL_LARGE_COUNT][OSC_POOL_LARGE_SIZE / 8];
+
+typedef struct {
+	uint8_t * start;
+	uint8_t * end;
+	uint16_t size;
+	uint16_t count;
+	void * free_list;    // a free block holds the next free block in its first word
+	uint16_t live;
+	uint16_t peak;
+	uint16_t carved;     // blocks handed out at least once, the rest have never been on the free list
+} pool_t;
+
+static pool_t pools[OSC_POOL_CLASSES] = {
+	{ (uint8_t *) pool_small, (uint8_t *) pool_small + sizeof(pool_small), OSC_POOL_SMALL_SIZE, OSC_POOL_SMALL_COUNT, 0, 0, 0, 0 },
+	{ (uint8_t *) pool_medium, (uint8_t *) pool_medium + sizeof(pool_medium), OSC_POOL_MEDIUM_SIZE, OSC_POOL_MEDIUM_COUNT, 0, 0, 0, 0 },
+	{ (uint8_t *) pool_large, (uint8_t *) pool_large + sizeof(pool_large), OSC_POOL_LARGE_SIZE, OSC_POOL_LARGE_COUNT, 0, 0, 0, 0 },
+};
+
+static uint32_t fallbacks = 0;
+static uint32_t failures = 0;
+
+// which pool a block came from, 0 for one from malloc
+static pool_t * pool_of(void * p) {
+	uint8_t i;
+	for (i = 0; i < OSC_POOL_CLASSES; i++) {
+		if (((uint8_t *) p >= pools[i].start) && ((uint8_t *) p < pools[i].end)) return &pools[i];
+	}
+	return 0;
+}
+
+static void * pool_take(pool_t * pool) {
+	void * p;
+
+	if (pool->free_list) {
+		p = pool->free_list;
+		pool->free_list = *(void **) p;
+	} else if (pool->carved < pool->count) {
+		p = pool->start + (pool->carved * pool->size);
+		pool->carved++;
+	} else {
+		return 0;
+	}
+	pool->live++;
+	if (pool->live > pool->peak) pool->peak = pool->live;
+	return p;
+}
+
+void * osc_pool_alloc(size_t size) {
+	uint8_t i;
+	void * p;
+
+	for (i = 0; i < OSC_POOL_CLASSES; i++) {
+		if (size <= pools[i].size) {
+			p = pool_take(&pools[i]);
+			if (p) return p;
+		}
+	}
+	p = malloc(size);
+	if (p) fallbacks++;
+	else failures++;
+	return p;
+}
+
+void osc_pool_free(void * p) {
+	pool_t * pool;
+
+	if (!p) return;
+	pool = pool_of(p);
+	if (!pool) {
+		free(p);
+		return;
+	}
+	*(void **) p = pool->free_list;
+	pool->free_list = p;
+	pool->live--;
+}
+
+// stays put while the block is big enough, so the one-more-arg growth in OSCMessage is mostly free.
+// shrinking to a smaller class moves it down if there is room, the incoming buffer
+// of a long message goes back to 16 bytes after every field and shouldn't hold on to a large block
+void * osc_pool_realloc(void * p, size_t size) {
+	pool_t * pool;
+	void * q;
+
+	if (!p) return osc_pool_alloc(size);
+	pool = pool_of(p);
+	// a malloc block stays with malloc
+	if (!pool) return realloc(p, size);
+	if (size <= pool->size) {
+		if ((pool == pools) || (size > (pool - 1)->size)) return p;
+		q = pool_take(pool - 1);
+		if (!q) return p;
+		memcpy(q, p, size);
+		osc_pool_free(p);
+		return q;
+	}
+
+	q = osc_pool_alloc(size);
+	if (!q) return 0;
+	memcpy(q, p, pool->size);
+	osc_pool_free(p);
+	return q;
+}
+
+void osc_pool_stats(uint8_t pool, osc_pool_stats_t * stats) {
+	if (pool >= OSC_POOL_CLASSES) return;
+	stats->size = pools[pool].size;
+	stats->count = pools[pool].count;
+	stats->live = pools[pool].live;
+	stats->peak = pools[pool].peak;
+}
+
+uint32_t osc_pool_fallbacks(void) {
+	return fallbacks;
+}
+
+uint32_t osc_pool_failures(void) {
+	return failures;
+}
@@ -0,0 +1,60 @@
+/*
+ * OSCPool.h
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#ifndef OSCPOOL_H_
+#define OSCPOOL_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// fixed block pools behind the OSC library's malloc / realloc / free, so
+// messages coming and going all day can't fragment the little heap there is.
+// a request goes to the smallest class it fits, if that class is used up the
+// next one up, past the largest it falls back to malloc and gets counted.
+// only the main loop builds messages, so there is no locking.
+//
+// small   OSCData (24 bytes), addresses, short strings, data arrays up to 6 args
+// medium  data arrays up to 16 args, small blobs, the incoming buffer while it is short
+// large   the longest fields: /oled/rle coming in (200 + 4, the incoming buffer
+//         gets to 220), /mst, /mev, /midiout and /sysex blobs, /curvetable's array
+//
+// the counts are the peaks from tests/replay_oscpool, which runs every message
+// the firmware takes and sends at its largest (40 small is a /stats/loop run
+// from /at in a DEBUG build).  that test fails if a change needs more
+#define OSC_POOL_SMALL_SIZE 24
+#define OSC_POOL_SMALL_COUNT 40
+#define OSC_POOL_MEDIUM_SIZE 64
+#define OSC_POOL_MEDIUM_COUNT 2
+#define OSC_POOL_LARGE_SIZE 224
+#define OSC_POOL_LARGE_COUNT 2
+
+#define OSC_POOL_CLASSES 3
+
+typedef struct {
+	uint16_t size;
+	uint16_t count;
+	uint16_t live;
+	uint16_t peak;    // most live at once since boot
+} osc_pool_stats_t;
+
+void * osc_pool_alloc(size_t size);
+void * osc_pool_realloc(void * p, size_t size);
+void osc_pool_free(void * p);
+
+// class 0 - 2, and the requests that went to malloc instead (ones malloc couldn't take either count too)
+void osc_pool_stats(uint8_t pool, osc_pool_stats_t * stats);
+uint32_t osc_pool_fallbacks(void);
+uint32_t osc_pool_failures(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* OSCPOOL_H_ */
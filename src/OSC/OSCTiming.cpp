@@ -135,6 +135,34 @@ osctime_t oscTime()
     return computeOscTime();
 }
 
+#elif defined(STM32F051)
+extern "C" {
+#include "../Timer.h"
+#include "../timesync.h"
+}
+
+// no wall clock here, the time starts at 0 at boot (TIM2, Timer.c),
+// once the host has sent /sync/set it is host time (timesync.c)
+static uint64_t savedmicros;
+
+static void latchOscTime()
+{
+    savedmicros = timer_micros64();
+}
+
+static osctime_t computeOscTime()
+{
+    osctime_t t;
+    timesync_to_ntp(timesync_host_micros(savedmicros), &t.seconds, &t.fractionofseconds);
+    return t;
+}
+
+osctime_t oscTime()
+{
+    latchOscTime();
+    return computeOscTime();
+}
+
 #else
 
 
@@ -3,20 +3,23 @@
 extern "C" {
 #include "uart.h"
 #include "BlinkLed.h"
+#include "Timer.h"
+#include "ramfunc.h"
 }
 
 extern uint8_t uart2_recv_buf[];
 extern uint16_t uart2_recv_buf_head;
 extern uint16_t uart2_recv_buf_tail;
+extern volatile uint32_t uart2_eot_micros;
 
 /*
  CONSTRUCTOR
  */
 SLIPEncodedSerial::SLIPEncodedSerial() {
 	rstate = WAITING;
-	rxPacketIndex = 0;
-	encodedBufIndex = 0;
+	rxMicros = 0;
 	decodedBufIndex = 0;
+	decodedLength = 0;
 }
 
 static const uint8_t eot = 0300;
@@ -24,16 +27,23 @@ static const uint8_t slipesc = 0333;
 static const uint8_t slipescend = 0334;
 static const uint8_t slipescesc = 0335;
 
+// uart2_send waits on the port anyway, so the encoding happens in its shadow
 int SLIPEncodedSerial::sendMessage(const uint8_t *buf, uint32_t len) {
 	uint32_t i;
-	encode(buf, len);
-	for (i = 0; i < encodedLength; i++) {
-		uart2_send(encodedBuf[i]);
+	int sent = 2;
+#ifdef DEBUG
+	txMicros = timer_micros();
+#endif
+	uart2_send(eot);
+	for (i = 0; i < len; i++) {
+		sent += encode(buf[i]);
 	}
-	return encodedLength;
+	uart2_send(eot);
+	return sent;
 }
 
-int SLIPEncodedSerial::recvMessage(void) {
+// the byte loop runs from RAM
+RAMFUNC int SLIPEncodedSerial::recvMessage(void) {
 	// process rx buffer, this might return before the whole thing
 	// is proccessed,  but we'll just get it next time
 
@@ -41,84 +51,58 @@ int SLIPEncodedSerial::recvMessage(void) {
 		uint8_t tmp8 = uart2_recv_buf[uart2_recv_buf_tail++];
 		uart2_recv_buf_tail %= UART2_BUFFER_SIZE;
 
-		if (rstate == WAITING) {
-			if (tmp8 == eot)
-				rstate = WAITING; // just keep waiting for something afer EOT
-			else {
-				rxPacketIndex = 0;
-				rxPacket[rxPacketIndex++] = tmp8;
-				rstate = RECEIVING;
-			}
-		} // waiting
-		else if (rstate == RECEIVING) {
-			if (rxPacketIndex >= MAX_MSG_SIZE) {
-				rstate = WAITING;
-				//AUX_LED_RED_ON;
-			} else if (tmp8 == eot) {
+		if (tmp8 == eot) {
+			if ((rstate == RECEIVING) || (rstate == ESCAPED)) {
 				rstate = WAITING;
-				decode(rxPacket, rxPacketIndex);
+				// the ISR stamps every END, if nothing is behind this one the stamp is its own
+				rxMicros = uart2_eot_micros;
+				if (uart2_recv_buf_tail != uart2_recv_buf_head) rxMicros = timer_micros();
+				decodedLength = decodedBufIndex;
 				return 1;
-			} else {
-				rxPacket[rxPacketIndex++] = tmp8;
-				rstate = RECEIVING;
 			}
-		} //receiving
+			rstate = WAITING;   // an END between messages, or after one that was too long
+			continue;
+		}
+
+		if (rstate == SKIPPING) continue;
+		if (rstate == WAITING) {
+			decodedBufIndex = 0;
+			rstate = RECEIVING;
+		}
+
+		if (rstate == ESCAPED) {
+			rstate = RECEIVING;
+			if (tmp8 == slipescend) tmp8 = eot;
+			else if (tmp8 == slipescesc) tmp8 = slipesc;
+			else continue;   // not a valid escape, both bytes are dropped
+		} else if (tmp8 == slipesc) {
+			rstate = ESCAPED;
+			continue;
+		}
+
+		if (decodedBufIndex >= MAX_MSG_SIZE) {
+			rstate = SKIPPING;
+			//AUX_LED_RED_ON;
+			continue;
+		}
+		decodedBuf[decodedBufIndex++] = tmp8;
 
 	} // gettin bytes
 	return 0;
 }
 
-//encode SLIP, put it in the encoded buffer
-void SLIPEncodedSerial::encode(uint8_t b) {
+//encode SLIP, straight out the port
+int SLIPEncodedSerial::encode(uint8_t b) {
 	if (b == eot) {
-		encodedBuf[encodedBufIndex++] = slipesc;
-		encodedBuf[encodedBufIndex++] = slipescend;
+		uart2_send(slipesc);
+		uart2_send(slipescend);
+		return 2;
 	} else if (b == slipesc) {
-		encodedBuf[encodedBufIndex++] = slipesc;
-		encodedBuf[encodedBufIndex++] = slipescesc;
+		uart2_send(slipesc);
+		uart2_send(slipescesc);
+		return 2;
 	} else {
-		encodedBuf[encodedBufIndex++] = b;
-	}
-}
-
-void SLIPEncodedSerial::encode(const uint8_t *buf, int size) {
-	beginPacket();
-	while (size--)
-		encode(*buf++);
-	endPacket();
-}
-
-// decode SLIP, put it in the decoded buffer
-void SLIPEncodedSerial::decode(const uint8_t *buf, int size) {
-	int i;
-	decodedBufIndex = 0;
-	i = 0;
-
-	while (i < size) {
-		if (buf[i] == slipesc) { // TODO error out here if slipescend or slipescesc doesn't follow slipesc
-			i++;
-			if (buf[i] == slipescend)
-				decodedBuf[decodedBufIndex++] = eot;
-			if (buf[i] == slipescesc)
-				decodedBuf[decodedBufIndex++] = slipesc;
-			i++;
-		} else {
-			decodedBuf[decodedBufIndex++] = buf[i];
-			i++;
-		}
+		uart2_send(b);
+		return 1;
 	}
-	decodedLength = decodedBufIndex;
-}
-
-//SLIP specific method which begins a transmitted packet
-void SLIPEncodedSerial::beginPacket() {
-	encodedBufIndex = 0;
-	encodedBuf[encodedBufIndex++] = eot;
 }
-
-//signify the end of the packet with an EOT
-void SLIPEncodedSerial::endPacket() {
-	encodedBuf[encodedBufIndex++] = eot;
-	encodedLength = encodedBufIndex;
-}
-
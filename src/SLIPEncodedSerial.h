@@ -3,9 +3,11 @@
 
 #include <stdint.h> 
 
-#define MAX_MSG_SIZE 256 // the maximum un encoded size.  the max encoded size will be this * 2 for slip overhead
+#define MAX_MSG_SIZE 224 // the maximum un encoded size, the largest block OSCPool has
 #define WAITING 1
 #define RECEIVING 2
+#define ESCAPED 3      // receiving, the last byte was an escape
+#define SKIPPING 4     // too long, dropping the rest up to the next END
 
 class SLIPEncodedSerial {
 
@@ -17,29 +19,23 @@ public:
 
 	uint8_t rstate;
 
-	// encoded message
-	uint8_t encodedBuf[MAX_MSG_SIZE * 2]; // the encoded can be up to 2 * longer
-	uint32_t encodedBufIndex;
-	uint32_t encodedLength;
-
-	// decoded message
+	// decoded message, bytes are decoded as they come off the rx ring
+	// and sent bytes are encoded straight into the port, so no other buffers
 	uint8_t decodedBuf[MAX_MSG_SIZE];
 	uint32_t decodedBufIndex;
 	uint32_t decodedLength;
 
-	uint8_t rxPacket[MAX_MSG_SIZE * 2];
-	uint32_t rxPacketIndex;
-
-	//SLIP specific method which begins a transmitted packet
-	void beginPacket();
+	// timer_micros() when the last message received ended, to the microsecond
+	// if nothing came in after it, otherwise when it was picked up
+	uint32_t rxMicros;
 
-	//SLIP specific method which ends a transmittedpacket
-	void endPacket();
-
-	void encode(const uint8_t *buf, int size);
-	void encode(uint8_t b);
+#ifdef DEBUG
+	// timer_micros() when the last sendMessage started writing to the port, for latency.h
+	uint32_t txMicros;
+#endif
 
-	void decode(const uint8_t *buf, int size);
+	// sends one byte escaped, returns the bytes that went out
+	int encode(uint8_t b);
 
 	int sendMessage(const uint8_t *buf, uint32_t len);
 
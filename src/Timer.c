@@ -1,6 +1,8 @@
 
 #include "Timer.h"
 #include "cortexm/ExceptionHandlers.h"
+#include "ramfunc.h"
+#include "cycles.h"
 
 // ----------------------------------------------------------------------------
 
@@ -13,13 +15,39 @@ timer_tick(void);
 
 volatile uint32_t timer_delayCount;
 volatile uint32_t stopwatch;
+volatile uint32_t timer_ticks;  // free running, never reset (unlike the stopwatch)
+static volatile uint32_t micros_high;   // TIM2 wraps, the top half of timer_micros64()
 
 // ----------------------------------------------------------------------------
 
 void timer_start(void) {
+	TIM_TimeBaseInitTypeDef TIM_TimeBaseStructure;
+	NVIC_InitTypeDef NVIC_InitStructure;
+
 	// Use SysTick as reference for the delay loops.
 	SysTick_Config(SystemCoreClock / TIMER_FREQUENCY_HZ);
 	led_flash_countdown = 0;
+
+	// TIM2 (32 bit) free runs at 1 MHz for the microsecond clock, the
+	// update interrupt every 71.6 minutes counts the wraps
+	RCC_APB1PeriphClockCmd(RCC_APB1Periph_TIM2, ENABLE);
+	TIM_TimeBaseStructInit(&TIM_TimeBaseStructure);
+	TIM_TimeBaseStructure.TIM_Prescaler = (SystemCoreClock / 1000000) - 1;
+	TIM_TimeBaseStructure.TIM_Period = 0xFFFFFFFF;
+	TIM_TimeBaseStructure.TIM_ClockDivision = 0;
+	TIM_TimeBaseStructure.TIM_CounterMode = TIM_CounterMode_Up;
+	TIM_TimeBaseInit(TIM2, &TIM_TimeBaseStructure);
+	// TimeBaseInit makes an update event to load the prescaler, that isn't a wrap
+	TIM_ClearFlag(TIM2, TIM_FLAG_Update);
+	TIM_ITConfig(TIM2, TIM_IT_Update, ENABLE);
+
+	NVIC_InitStructure.NVIC_IRQChannel = TIM2_IRQn;
+	NVIC_InitStructure.NVIC_IRQChannelPriority = 3;
+	NVIC_InitStructure.NVIC_IRQChannelCmd = ENABLE;
+	NVIC_Init(&NVIC_InitStructure);
+
+	micros_high = 0;
+	TIM_Cmd(TIM2, ENABLE);
 }
 
 void stopwatchStart(void) {
@@ -31,6 +59,34 @@ uint32_t stopwatchReport(void) {
 	return stopwatch;
 }
 
+// microseconds since boot, wraps about every 71 minutes.
+// this is the TIM2 count, separate from the stopwatch and timer_ticks
+uint32_t timer_micros(void) {
+	return TIM2->CNT;
+}
+
+// microseconds since boot, doesn't wrap
+uint64_t timer_micros64(void) {
+	uint32_t primask = __get_PRIMASK();
+	uint32_t high, low;
+
+	__disable_irq();
+	high = micros_high;
+	low = TIM2->CNT;
+	// wrapped but the interrupt hasn't counted it yet (IRQs off, or called from a higher priority ISR)
+	if ((TIM2->SR & TIM_SR_UIF) && (low < 0x80000000)) high++;
+	__set_PRIMASK(primask);
+
+	return ((uint64_t) high << 32) | low;
+}
+
+void TIM2_IRQHandler(void) {
+	if (TIM2->SR & TIM_SR_UIF) {
+		TIM2->SR = ~TIM_SR_UIF;
+		micros_high++;
+	}
+}
+
 void timer_sleep(uint32_t ticks) {
 	timer_delayCount = ticks;
 
@@ -39,7 +95,10 @@ void timer_sleep(uint32_t ticks) {
 		;
 }
 
-void timer_tick(void) {
+isr_cycles_t isr_cycles_tick;
+
+// every 100 us, from RAM
+RAMFUNC void timer_tick(void) {
 	// Decrement to zero the counter used by the delay routine.
 	if (timer_delayCount != 0u) {
 		--timer_delayCount;
@@ -47,6 +106,7 @@ void timer_tick(void) {
 
 	// increment stopwatch
 	stopwatch++;
+	timer_ticks++;
 	if (led_flash_countdown != 0u) {
 		--led_flash_countdown;
 	}
@@ -55,8 +115,10 @@ void timer_tick(void) {
 
 // ----- SysTick_Handler() ----------------------------------------------------
 
-void SysTick_Handler(void) {
+RAMFUNC void SysTick_Handler(void) {
+	ISR_CYCLES_BEGIN();
 	timer_tick();
+	ISR_CYCLES_END(isr_cycles_tick);
 }
 
 // ----------------------------------------------------------------------------
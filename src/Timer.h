@@ -10,6 +10,7 @@
 #define TIMER_FREQUENCY_HZ (10000u)  // one tenth of millisecond
 
 extern volatile uint32_t timer_delayCount;
+extern volatile uint32_t timer_ticks;
 
 void timer_start(void);
 
@@ -19,6 +20,10 @@ void stopwatchStart(void);
 
 uint32_t stopwatchReport(void);
 
+// TIM2, 1 us resolution, free running from timer_start()
+uint32_t timer_micros(void);
+uint64_t timer_micros64(void);
+
 // ----------------------------------------------------------------------------
 
 #endif // TIMER_H_
@@ -0,0 +1,245 @@
+/*
+ * config.c
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#include "config.h"
+
+// The store is a log: a setting is changed by appending a record, the last
+// record for a key wins.  Two pages are used in turn, when the active one
+// fills up the latest value of every key is copied to the other one and
+// the full page gets erased, so both pages wear at the same rate and an
+// erase only happens every couple hundred changes.
+//
+// page:    status (halfword), generation (halfword), records...
+// record:  value (halfword), tag (halfword)
+//
+// The tag holds the key and a check byte and is programmed after the value,
+// so a record cut short by a power failure never reads back as valid.  A page
+// being filled by a copy is marked RECEIVING and only becomes VALID once the
+// copy is complete, if power fails with both pages VALID the higher
+// generation is the newer one.
+
+// last 2 pages of the 64K part, these must match the end of FLASH in mem.ld
+#define CONFIG_PAGE_0 0x0800F800
+#define CONFIG_PAGE_1 0x0800FC00
+#define CONFIG_PAGE_SIZE 0x400
+#define CONFIG_RECORDS_PER_PAGE ((CONFIG_PAGE_SIZE - 4) / 4)
+
+#define PAGE_ERASED 0xFFFF
+#define PAGE_RECEIVING 0xEEEE
+#define PAGE_VALID 0x0000
+
+#define FLASH_HALFWORD(a) (*(__IO uint16_t *) (a))
+
+static uint16_t config_values[CONFIG_NUM_KEYS];
+static uint32_t config_stored[2];   // bit per key, has a value
+static uint32_t config_dirty[2];    // bit per key, needs writing to flash
+
+static uint32_t page_active;        // page records are appended to
+static uint16_t page_generation;    // of the active page
+static uint32_t page_next_record;   // next free record in the active page
+static uint32_t page_erase = 0;     // page waiting to be erased (0 for none)
+
+// moving to the other page
+static uint8_t transferring = 0;
+static uint8_t transfer_key;
+static uint32_t transfer_next_record;
+
+static uint8_t key_bit(uint32_t *set, uint8_t key) {
+	return (set[key >> 5] >> (key & 0x1f)) & 1;
+}
+
+static void key_bit_set(uint32_t *set, uint8_t key) {
+	set[key >> 5] |= (1 << (key & 0x1f));
+}
+
+static void key_bit_clear(uint32_t *set, uint8_t key) {
+	set[key >> 5] &= ~(1 << (key & 0x1f));
+}
+
+static uint16_t config_tag(uint8_t key, uint16_t value) {
+	return key | (((key ^ value ^ (value >> 8) ^ 0x5A) & 0xFF) << 8);
+}
+
+static uint32_t record_address(uint32_t page, uint32_t record) {
+	return page + 4 + (record * 4);
+}
+
+static uint32_t other_page(uint32_t page) {
+	return (page == CONFIG_PAGE_0) ? CONFIG_PAGE_1 : CONFIG_PAGE_0;
+}
+
+static uint8_t flash_program(uint32_t address, uint16_t data) {
+	FLASH_Status status;
+
+	FLASH_Unlock();
+	FLASH_ClearFlag(FLASH_FLAG_EOP | FLASH_FLAG_PGERR | FLASH_FLAG_WRPERR);
+	status = FLASH_ProgramHalfWord(address, data);
+	FLASH_Lock();
+
+	return (status == FLASH_COMPLETE);
+}
+
+static void flash_erase(uint32_t page) {
+	FLASH_Unlock();
+	FLASH_ClearFlag(FLASH_FLAG_EOP | FLASH_FLAG_PGERR | FLASH_FLAG_WRPERR);
+	FLASH_ErasePage(page);
+	FLASH_Lock();
+}
+
+static uint8_t page_blank(uint32_t page) {
+	uint32_t i;
+
+	for (i = 0; i < CONFIG_PAGE_SIZE; i += 2) {
+		if (FLASH_HALFWORD(page + i) != 0xFFFF) return 0;
+	}
+	return 1;
+}
+
+static uint8_t write_record(uint32_t page, uint32_t record, uint8_t key) {
+	uint16_t value = config_values[key];
+
+	if (!flash_program(record_address(page, record), value)) return 0;
+	return flash_program(record_address(page, record) + 2, config_tag(key, value));
+}
+
+static void load_page(uint32_t page) {
+	uint32_t i;
+	uint16_t value;
+	uint16_t tag;
+	uint8_t key;
+
+	page_next_record = 0;
+	for (i = 0; i < CONFIG_RECORDS_PER_PAGE; i++) {
+		value = FLASH_HALFWORD(record_address(page, i));
+		tag = FLASH_HALFWORD(record_address(page, i) + 2);
+
+		if ((value == 0xFFFF) && (tag == 0xFFFF)) continue;
+		page_next_record = i + 1;   // partly written records still use up the slot
+
+		key = tag & 0xFF;
+		if ((key < CONFIG_NUM_KEYS) && (tag == config_tag(key, value))) {
+			config_values[key] = value;
+			key_bit_set(config_stored, key);
+		}
+	}
+}
+
+void config_init(void) {
+	uint16_t status0 = FLASH_HALFWORD(CONFIG_PAGE_0);
+	uint16_t status1 = FLASH_HALFWORD(CONFIG_PAGE_1);
+	uint16_t generation0 = FLASH_HALFWORD(CONFIG_PAGE_0 + 2);
+	uint16_t generation1 = FLASH_HALFWORD(CONFIG_PAGE_1 + 2);
+
+	config_stored[0] = config_stored[1] = 0;
+	config_dirty[0] = config_dirty[1] = 0;
+	transferring = 0;
+
+	if ((status0 == PAGE_VALID) && (status1 == PAGE_VALID)) {
+		// power went after a move completed, before the old page was erased
+		page_active = ((int16_t) (generation1 - generation0) > 0) ? CONFIG_PAGE_1 : CONFIG_PAGE_0;
+	}
+	else if (status0 == PAGE_VALID) {
+		page_active = CONFIG_PAGE_0;
+	}
+	else if (status1 == PAGE_VALID) {
+		page_active = CONFIG_PAGE_1;
+	}
+	else {
+		// first boot (or nothing usable), start over on page 0
+		page_active = CONFIG_PAGE_0;
+		flash_erase(CONFIG_PAGE_0);
+		flash_program(CONFIG_PAGE_0 + 2, 0);
+		flash_program(CONFIG_PAGE_0, PAGE_VALID);
+	}
+
+	// the spare page has to be blank before the next move, get to it when idle
+	page_erase = page_blank(other_page(page_active)) ? 0 : other_page(page_active);
+
+	page_generation = FLASH_HALFWORD(page_active + 2);
+	load_page(page_active);
+}
+
+uint8_t config_get(uint8_t key, uint16_t *value) {
+	if ((key >= CONFIG_NUM_KEYS) || !key_bit(config_stored, key)) return 0;
+	*value = config_values[key];
+	return 1;
+}
+
+void config_set(uint8_t key, uint16_t value) {
+	if (key >= CONFIG_NUM_KEYS) return;
+	if (key_bit(config_stored, key) && (config_values[key] == value)) return;
+
+	config_values[key] = value;
+	key_bit_set(config_stored, key);
+	key_bit_set(config_dirty, key);
+}
+
+void config_forget(uint8_t key) {
+	if (key >= CONFIG_NUM_KEYS) return;
+	key_bit_clear(config_stored, key);
+	key_bit_clear(config_dirty, key);
+}
+
+uint8_t config_pending(void) {
+	return page_erase || transferring || config_dirty[0] || config_dirty[1];
+}
+
+void config_poll(void) {
+	uint32_t target;
+	uint8_t key;
+
+	// erasing is the slow one (~20 ms), it gets a call to itself
+	if (page_erase) {
+		flash_erase(page_erase);
+		page_erase = 0;
+		return;
+	}
+
+	if (transferring) {
+		target = other_page(page_active);
+
+		// copy one key per call
+		while ((transfer_key < CONFIG_NUM_KEYS) && !key_bit(config_stored, transfer_key))
+			transfer_key++;
+
+		if (transfer_key < CONFIG_NUM_KEYS) {
+			if (write_record(target, transfer_next_record, transfer_key))
+				key_bit_clear(config_dirty, transfer_key);
+			transfer_next_record++;
+			transfer_key++;
+			return;
+		}
+
+		// all there, switch over and let the old page go
+		flash_program(target, PAGE_VALID);
+		page_erase = page_active;
+		page_active = target;
+		page_generation++;
+		page_next_record = transfer_next_record;
+		transferring = 0;
+		return;
+	}
+
+	for (key = 0; key < CONFIG_NUM_KEYS; key++) {
+		if (key_bit(config_dirty, key)) break;
+	}
+	if (key == CONFIG_NUM_KEYS) return;
+
+	if (page_next_record >= CONFIG_RECORDS_PER_PAGE) {
+		// full, start the move to the other page (it is blank by now)
+		target = other_page(page_active);
+		flash_program(target + 2, page_generation + 1);
+		flash_program(target, PAGE_RECEIVING);
+		transfer_key = 0;
+		transfer_next_record = 0;
+		transferring = 1;
+		return;
+	}
+
+	if (write_record(page_active, page_next_record, key))
+		key_bit_clear(config_dirty, key);
+	page_next_record++;
+}
@@ -0,0 +1,47 @@
+/*
+ * config.h
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#ifndef CONFIG_H_
+#define CONFIG_H_
+
+#include "stm32f0xx.h"
+
+// settings that survive a power cycle, kept in the last 2 pages of flash
+// (mem.ld stops the program from growing into them)
+
+// keys
+#define CONFIG_MIDI_CHANNEL 0   // from before the mask, moved to it at boot and then forgotten
+#define CONFIG_KNOB_RATE 1
+#define CONFIG_FOOT_MODE 2
+#define CONFIG_KNOB_CURVE 3     // 5 of these, one per knob
+#define CONFIG_CURVE_USER 8     // 33 of these, the points of the user curve
+#define CONFIG_MIDI_MODE 41
+#define CONFIG_MIDI_CHANNEL_MASK 42
+#define CONFIG_MIDI_THRU 43
+#define CONFIG_REPLY_LEAD 44
+#define CONFIG_NUM_KEYS 45
+
+// load what is in flash, call once at boot (this may erase a page)
+void config_init(void);
+
+// returns 1 and fills in value if the key has been stored
+uint8_t config_get(uint8_t key, uint16_t *value);
+
+// only updates RAM, the flash write happens later in config_poll()
+void config_set(uint8_t key, uint16_t value);
+
+// drops a key from RAM, it isn't carried over the next time the records
+// move to the other page (until then the old record is still in flash)
+void config_forget(uint8_t key);
+
+// does one step of pending flash work (a record, a page copy step or an erase),
+// only call when it is ok for the CPU to stall on flash
+void config_poll(void);
+
+// returns 1 if config_poll() has something to do
+uint8_t config_pending(void);
+
+#endif /* CONFIG_H_ */
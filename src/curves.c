@@ -0,0 +1,65 @@
+/*
+ * curves.c
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#include "curves.h"
+
+// The standard tables are worked out by the compiler (the math builtins
+// fold to constants) so they end up in flash with no startup cost.
+
+// point i (0 - 32) as 0.0 - 1.0
+#define CURVE_X(i) ((double) (i) / (CURVE_POINTS - 1))
+// 0.0 - 1.0 to 0 - CURVE_MAX, rounded
+#define CURVE_Y(y) ((uint16_t) ((y) * CURVE_MAX + 0.5))
+
+// how hard the log and anti log curves bend
+#define CURVE_LOG_K 15.0
+
+#define LOG_PT(i) CURVE_Y(__builtin_log(1.0 + CURVE_LOG_K * CURVE_X(i)) / __builtin_log(1.0 + CURVE_LOG_K))
+#define ANTILOG_PT(i) CURVE_Y((__builtin_pow(1.0 + CURVE_LOG_K, CURVE_X(i)) - 1.0) / CURVE_LOG_K)
+#define SCURVE_PT(i) CURVE_Y(CURVE_X(i) * CURVE_X(i) * (3.0 - 2.0 * CURVE_X(i)))
+#define LINEAR_PT(i) CURVE_Y(CURVE_X(i))
+
+#define CURVE_TABLE(PT) { \
+	PT(0), PT(1), PT(2), PT(3), PT(4), PT(5), PT(6), PT(7), PT(8), PT(9), PT(10),\
+	PT(11), PT(12), PT(13), PT(14), PT(15), PT(16), PT(17), PT(18), PT(19), PT(20), PT(21),\
+	PT(22), PT(23), PT(24), PT(25), PT(26), PT(27), PT(28), PT(29), PT(30), PT(31), PT(32) }
+
+static const uint16_t curve_log[CURVE_POINTS] = CURVE_TABLE(LOG_PT);
+static const uint16_t curve_antilog[CURVE_POINTS] = CURVE_TABLE(ANTILOG_PT);
+static const uint16_t curve_scurve[CURVE_POINTS] = CURVE_TABLE(SCURVE_PT);
+
+// starts out linear until the host uploads something
+uint16_t curve_user[CURVE_POINTS] = CURVE_TABLE(LINEAR_PT);
+
+static const uint16_t * const curve_tables[CURVE_COUNT] = {
+	0,   // linear doesn't need one
+	curve_log,
+	curve_antilog,
+	curve_scurve,
+	curve_user
+};
+
+uint16_t curve_apply(uint8_t curve, uint16_t v) {
+	const uint16_t *t;
+	uint32_t pos;
+	uint32_t i;
+	int32_t frac;
+
+	if (v > CURVE_MAX) v = CURVE_MAX;
+	if ((curve == CURVE_LINEAR) || (curve >= CURVE_COUNT)) return v;
+
+	t = curve_tables[curve];
+
+	// stretch 0 - 1023 to 0 - 1024 so the top of the knob lands on the last point,
+	// then it's 5 bits of segment and 5 bits of fraction
+	pos = v + (v >> 9);
+	i = pos >> 5;
+	if (i >= (CURVE_POINTS - 1)) return t[CURVE_POINTS - 1];
+	frac = pos & 0x1f;
+
+	// signed, user tables don't have to go up
+	return t[i] + ((((int32_t) t[i + 1] - (int32_t) t[i]) * frac) >> 5);
+}
@@ -0,0 +1,29 @@
+/*
+ * curves.h
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#ifndef CURVES_H_
+#define CURVES_H_
+
+#include <stdint.h>
+
+// knob response curves
+#define CURVE_LINEAR 0
+#define CURVE_LOG 1        // fast at the start, like an audio taper
+#define CURVE_ANTILOG 2    // slow at the start, the inverse of log
+#define CURVE_SCURVE 3     // slow at both ends
+#define CURVE_USER 4       // table uploaded by the host
+#define CURVE_COUNT 5
+
+#define CURVE_POINTS 33    // 32 segments across the input
+#define CURVE_MAX 1023     // 10 bit in, 10 bit out
+
+// the user table, points are spread evenly across the input
+extern uint16_t curve_user[CURVE_POINTS];
+
+// map a 10 bit knob value through a curve
+uint16_t curve_apply(uint8_t curve, uint16_t v);
+
+#endif /* CURVES_H_ */
@@ -0,0 +1,64 @@
+/*
+ * cycles.h
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#ifndef CYCLES_H_
+#define CYCLES_H_
+
+#include "cmsis_device.h"
+#include "Timer.h"
+
+// CPU cycles from SysTick, it counts HCLK down from LOAD to 0 every tick (100 us),
+// so anything shorter than a tick can be timed to the cycle.  the M0 has no cycle counter.
+
+__attribute__((always_inline)) static inline uint32_t cycles_now(void) {
+	return SysTick->VAL;
+}
+
+__attribute__((always_inline)) static inline uint32_t cycles_since(uint32_t start) {
+	uint32_t now = SysTick->VAL;
+	if (now <= start) return start - now;
+	return start + SysTick->LOAD + 1 - now;   // wrapped once
+}
+
+// a running cycle count for spans longer than a tick, ticks so far times the reload
+// plus how far into this one SysTick is.  wraps about every 89 s at 48 MHz, fine for
+// differences.  if the count has reloaded but the handler hasn't run yet (something
+// with a higher priority is running) the tick it is about to add gets counted here
+__attribute__((always_inline)) static inline uint32_t cycles_stamp(void) {
+	uint32_t ticks, val, pending;
+
+	do {
+		ticks = timer_ticks;
+		val = SysTick->VAL;
+		pending = SCB->ICSR & SCB_ICSR_PENDSTSET_Msk;
+	} while (ticks != timer_ticks);
+	if (pending && (val > (SysTick->LOAD >> 1))) ticks++;
+	return (ticks * (SysTick->LOAD + 1)) + (SysTick->LOAD - val);
+}
+
+// handler entry to exit, not counting the 16 cycles the core spends stacking on the way in and out
+typedef struct {
+	uint16_t last;
+	uint16_t max;
+} isr_cycles_t;
+
+#ifdef DEBUG
+#define ISR_CYCLES_BEGIN() uint32_t isr_cycles_start = cycles_now()
+#define ISR_CYCLES_END(s) do { \
+		uint16_t c = cycles_since(isr_cycles_start); \
+		(s).last = c; \
+		if (c > (s).max) (s).max = c; \
+	} while (0)
+#else
+#define ISR_CYCLES_BEGIN()
+#define ISR_CYCLES_END(s)
+#endif
+
+extern isr_cycles_t isr_cycles_host;   // USART2
+extern isr_cycles_t isr_cycles_midi;   // USART1, MIDI parser included
+extern isr_cycles_t isr_cycles_tick;   // SysTick
+
+#endif /* CYCLES_H_ */
@@ -0,0 +1,91 @@
+/*
+ * frametime.c
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#include "frametime.h"
+
+static uint32_t nf_time;          // timer_micros() at the last /nf
+static uint32_t reply_time;
+static uint8_t replied = 1;       // reply for the current frame is out
+static uint8_t learned = 0;       // intervals seen since the last pause
+static uint8_t lead = FRAMETIME_LEAD_DEFAULT;
+
+// averages keep 3 fractional bits, they move 1/8 of the way each frame
+static uint32_t interval8;
+static uint32_t jitter8;
+static int32_t slack8;
+static int32_t slack_min = 0x7FFFFFFF;
+static uint32_t late;
+static uint32_t frames;
+static uint32_t delay = FRAMETIME_DEFAULT_DELAY;
+
+static void update_delay(void) {
+	uint32_t interval = interval8 >> 3;
+
+	if (learned < FRAMETIME_LEARN_FRAMES) delay = FRAMETIME_DEFAULT_DELAY;
+	else delay = interval - ((interval * lead) / 100);
+}
+
+void frametime_nf(uint32_t now) {
+	uint32_t interval = now - nf_time;
+	int32_t slack;
+
+	frames++;
+
+	// how the last reply did, after a pause the gap says nothing about that
+	if ((frames > 1) && (interval <= FRAMETIME_MAX_INTERVAL)) {
+		if (!replied) {
+			late++;
+		} else {
+			slack = now - reply_time;
+			slack8 += (slack * 8 - slack8) / 8;
+			if (slack < slack_min) slack_min = slack;
+		}
+	}
+
+	if ((frames == 1) || (interval > FRAMETIME_MAX_INTERVAL)) {
+		learned = 0;
+	} else if (!learned) {
+		interval8 = interval << 3;
+		jitter8 = 0;
+		learned = 1;
+	} else {
+		int32_t d = (int32_t) (interval << 3) - (int32_t) interval8;
+		interval8 += d / 8;
+		if (d < 0) d = -d;
+		jitter8 += (d - (int32_t) jitter8) / 8;
+		if (learned < FRAMETIME_LEARN_FRAMES) learned++;
+	}
+
+	nf_time = now;
+	replied = 0;
+	update_delay();
+}
+
+uint8_t frametime_reply_due(uint32_t now) {
+	return !replied && ((now - nf_time) >= delay);
+}
+
+void frametime_replied(uint32_t now) {
+	replied = 1;
+	reply_time = now;
+}
+
+void frametime_set_lead(uint8_t percent) {
+	if (percent > FRAMETIME_LEAD_MAX) percent = FRAMETIME_LEAD_MAX;
+	lead = percent;
+	update_delay();
+}
+
+void frametime_stats(frametime_stats_t * stats) {
+	stats->interval = interval8 >> 3;
+	stats->jitter = jitter8 >> 3;
+	stats->delay = delay;
+	stats->slack = slack8 / 8;
+	stats->slack_min = (slack_min == 0x7FFFFFFF) ? 0 : slack_min;
+	stats->late = late;
+	stats->frames = frames;
+	slack_min = 0x7FFFFFFF;
+}
@@ -0,0 +1,42 @@
+/*
+ * frametime.h
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#ifndef FRAMETIME_H_
+#define FRAMETIME_H_
+
+#include <stdint.h>
+
+// when to send the frame reply (MIDI and knobs) back to the renderer.
+// the /nf interval is learned as it goes, and the reply goes out a fraction
+// (the lead) of the interval before the next /nf is expected, as late as it can
+// be while still landing in time.  until the interval is known (or after a
+// pause) it goes out a fixed 25 ms after /nf like it always did.
+
+#define FRAMETIME_DEFAULT_DELAY 25000   // us
+#define FRAMETIME_LEAD_DEFAULT 25       // % of the interval, 25 ms at 30 fps like before
+#define FRAMETIME_LEAD_MAX 90
+#define FRAMETIME_MAX_INTERVAL 250000   // us, a gap longer than this is a pause, start learning again
+#define FRAMETIME_LEARN_FRAMES 4
+
+typedef struct {
+	uint32_t interval;    // us between /nf, averaged
+	uint32_t jitter;      // us, average distance from that
+	uint32_t delay;       // us after /nf the reply goes
+	int32_t slack;        // us the reply was ahead of the next /nf, averaged
+	int32_t slack_min;    // the closest since the last time these were read
+	uint32_t late;        // /nf came before the reply for the last frame went
+	uint32_t frames;
+} frametime_stats_t;
+
+void frametime_nf(uint32_t now);
+uint8_t frametime_reply_due(uint32_t now);
+void frametime_replied(uint32_t now);
+void frametime_set_lead(uint8_t percent);
+
+// slack_min starts over after this
+void frametime_stats(frametime_stats_t * stats);
+
+#endif /* FRAMETIME_H_ */
@@ -0,0 +1,45 @@
+/*
+ * latency.c
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#include "latency.h"
+
+#ifdef DEBUG
+
+static latency_probe_t probes[LAT_PROBES];
+
+void latency_record(uint8_t probe, uint32_t us) {
+	latency_probe_t * p = &probes[probe];
+	uint32_t v = us >> 4;
+	uint8_t b = 0;
+
+	// no CLZ on the M0, at most 11 shifts
+	while (v && (b < (LAT_BUCKETS - 1))) {
+		v >>= 1;
+		b++;
+	}
+	if (p->buckets[b] < 0xFFFF) p->buckets[b]++;
+
+	p->count++;
+	p->total += us;
+	if (us > p->max) p->max = us;
+}
+
+void latency_get(uint8_t probe, latency_probe_t * stats) {
+	*stats = probes[probe];
+}
+
+void latency_clear(void) {
+	uint8_t i, b;
+
+	for (i = 0; i < LAT_PROBES; i++) {
+		probes[i].count = 0;
+		probes[i].total = 0;
+		probes[i].max = 0;
+		for (b = 0; b < LAT_BUCKETS; b++) probes[i].buckets[b] = 0;
+	}
+}
+
+#endif
@@ -0,0 +1,48 @@
+/*
+ * latency.h
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#ifndef LATENCY_H_
+#define LATENCY_H_
+
+#include <stdint.h>
+
+// end to end times through the firmware, debug builds only.  each probe is a
+// span in us (TIM2) from where something starts to a point along its way out,
+// counted into power of two buckets.  in a release build the macros are
+// empty, the timestamps they take never get declared and none of this is linked.
+
+// probes
+#define LAT_KEY_EVENT 0        // key first reads different -> debounced /key event
+#define LAT_KEY_TX_START 1     // key first reads different -> /key starts out to the host
+#define LAT_KEY_TX_DONE 2      // key first reads different -> last byte of /key into USART2
+#define LAT_NF_DISPATCH 3      // last byte of /nf in -> newFrame() runs
+#define LAT_NF_REPLY_START 4   // last byte of /nf in -> frame reply starts out
+#define LAT_NF_REPLY_DONE 5    // last byte of /nf in -> last byte of the reply into USART2
+#define LAT_PROBES 6
+
+// bucket 0 is under 16 us, each one after is twice as wide, the last takes the rest (16 ms and up)
+#define LAT_BUCKETS 12
+
+typedef struct {
+	uint32_t count;
+	uint32_t total;      // us, for the mean
+	uint32_t max;
+	uint16_t buckets[LAT_BUCKETS];
+} latency_probe_t;
+
+#ifdef DEBUG
+#define LATENCY_STAMP(t) ((t) = timer_micros())
+#define LATENCY(p, from, to) latency_record((p), (to) - (from))
+
+void latency_record(uint8_t probe, uint32_t us);
+void latency_get(uint8_t probe, latency_probe_t * stats);
+void latency_clear(void);
+#else
+#define LATENCY_STAMP(t)
+#define LATENCY(p, from, to)
+#endif
+
+#endif /* LATENCY_H_ */
@@ -0,0 +1,100 @@
+/*
+ * loopprof.c
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#include "loopprof.h"
+
+#ifdef DEBUG
+
+#include "cycles.h"
+
+typedef struct {
+	uint32_t min;
+	uint32_t max;
+	uint64_t total;
+	uint32_t n;
+} stage_t;
+
+// the last one is the whole pass
+static stage_t stages[LOOP_STAGES + 1];
+static uint32_t passes = 0;
+static uint32_t mark;           // cycles_stamp() at the last mark
+static uint32_t pass_start;
+static uint8_t started = 0;
+
+static void count(stage_t * s, uint32_t c) {
+	if (c < s->min) s->min = c;
+	if (c > s->max) s->max = c;
+	s->total += c;
+	s->n++;
+}
+
+void loopprof_begin(void) {
+	uint32_t now = cycles_stamp();
+
+	// the first pass after a clear has nothing to close
+	if (started) {
+		count(&stages[LOOP_STAGES], now - pass_start);
+		passes++;
+	}
+	started = 1;
+	pass_start = now;
+	mark = now;
+}
+
+void loopprof_mark(uint8_t stage) {
+	uint32_t now = cycles_stamp();
+
+	if (started) count(&stages[stage], now - mark);
+	mark = now;
+}
+
+void loopprof_get(uint8_t stage, loopprof_stage_t * stats) {
+	stage_t * s = &stages[stage];
+
+	stats->min = s->n ? s->min : 0;
+	stats->max = s->max;
+	stats->mean = s->n ? (uint32_t) (s->total / s->n) : 0;
+}
+
+uint32_t loopprof_passes(void) {
+	return passes;
+}
+
+// counting starts again at the top of the next pass
+void loopprof_clear(void) {
+	uint8_t i;
+
+	for (i = 0; i <= LOOP_STAGES; i++) {
+		stages[i].min = 0xFFFFFFFF;
+		stages[i].max = 0;
+		stages[i].total = 0;
+		stages[i].n = 0;
+	}
+	passes = 0;
+	started = 0;
+}
+
+#ifdef TRACE
+#include "diag/Trace.h"
+
+static const char * const stage_names[LOOP_STAGES + 1] = {
+	"sched", "host rx", "keys", "foot", "sysex", "oled",
+	"knobs", "knob tx", "reply", "flash", "pass"
+};
+
+void loopprof_trace(void) {
+	loopprof_stage_t stats;
+	uint8_t i;
+
+	trace_printf("loop, %u passes, cycles min / mean / max\n", (unsigned) passes);
+	for (i = 0; i <= LOOP_STAGES; i++) {
+		loopprof_get(i, &stats);
+		trace_printf("%8s %8u %8u %8u\n", stage_names[i], (unsigned) stats.min, (unsigned) stats.mean, (unsigned) stats.max);
+	}
+}
+#endif
+
+#endif
@@ -0,0 +1,59 @@
+/*
+ * loopprof.h
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#ifndef LOOPPROF_H_
+#define LOOPPROF_H_
+
+#include <stdint.h>
+
+// where the main loop spends its time, debug builds only.  the loop marks the
+// end of each stage and the cycles since the last mark (cycles_stamp(), so
+// spans can cover many SysTicks) go to that stage.  interrupts that land in a
+// stage count against it.  in a release build the macros are empty.
+
+// stages, in loop order
+#define LOOP_SCHED 0      // /at queue and the LED
+#define LOOP_HOST_RX 1    // recvMessage, fill and dispatch
+#define LOOP_KEYS 2       // scanKeys and checkForKeyEvent (with any /key sends)
+#define LOOP_FOOT 3       // checkFootSwitch
+#define LOOP_SYSEX 4      // checkSysex
+#define LOOP_OLED 5       // ssd1306_poll, 0 cycles without CONFIG_OLED
+#define LOOP_KNOBS 6      // updateKnobs
+#define LOOP_KNOB_TX 7    // checkKnobMotion
+#define LOOP_REPLY 8      // the frame reply
+#define LOOP_FLASH 9      // settings to flash on a /save
+#define LOOP_STAGES 10
+
+typedef struct {
+	uint32_t min;
+	uint32_t max;
+	uint32_t mean;
+} loopprof_stage_t;
+
+#ifdef DEBUG
+#define LOOPPROF_BEGIN() loopprof_begin()
+#define LOOPPROF_MARK(s) loopprof_mark(s)
+
+void loopprof_begin(void);
+void loopprof_mark(uint8_t stage);
+
+// stage is one of the above, or LOOP_STAGES for the whole pass (top to top)
+void loopprof_get(uint8_t stage, loopprof_stage_t * stats);
+uint32_t loopprof_passes(void);
+void loopprof_clear(void);
+
+// through diag/Trace.h, only in a build with TRACE and (the M0 has no ITM)
+// OS_USE_TRACE_SEMIHOSTING_DEBUG.  semihosting stops the core at a BKPT, with no
+// debugger attached that is a hard fault, so those builds only run under one
+#ifdef TRACE
+void loopprof_trace(void);
+#endif
+#else
+#define LOOPPROF_BEGIN()
+#define LOOPPROF_MARK(s)
+#endif
+
+#endif /* LOOPPROF_H_ */
@@ -3,6 +3,7 @@
 // ----------------------------------------------------------------------------
 
 #include <stdio.h>
+#include <string.h>
 #include "diag/Trace.h"
 
 extern "C" {
@@ -12,36 +13,88 @@ extern "C" {
 #include "BlinkLed.h"
 #include "ssd1306.h"
 #include "midi.h"
+#include "curves.h"
+#include "config.h"
+#include "midiclock.h"
+#include "sysex.h"
+#include "memstats.h"
+#include "cycles.h"
+#include "timesync.h"
+#include "frametime.h"
+#include "sched.h"
+#include "latency.h"
+#include "loopprof.h"
 }
 
 #include "OSC/OSCMessage.h"
 #include "SLIPEncodedSerial.h"
 #include "OSC/SimpleWriter.h"
+#include "OSC/OSCPool.h"
 
-// MIDI buffers
-extern uint8_t uart1_recv_buf[];
-extern uint16_t uart1_recv_buf_head;
-extern uint16_t uart1_recv_buf_tail;
+// host serial buffer
+extern uint16_t uart2_recv_peak;
+extern uint32_t uart2_overruns;
+extern uint32_t uart2_recv_dropped;
+extern uint16_t uart1_send_peak;
+extern uint32_t uart1_send_dropped;
+uint32_t slip_msg_peak = 0;   // longest decoded message, against MAX_MSG_SIZE
 
 // MIDI channel
 extern int channelIn_;
 
 // then the MIDI stuff gets packed in this blob
-extern uint8_t midi_blob[23];  // 5 bytes CC, 16 bytes for note states, 1 byte sync number, 1 byte program
 uint8_t midi_blob_sent = 1;  // flag so midi blob only goes out 1 / frame
 extern uint8_t new_midi_flag;
+extern uint8_t midi_mode;
+#define MIDI_CC_PAIRS_MAX 64  // keeps /mcc inside the 256 byte OSC buffer
+#define MIDI_STATE_RECORDS_MAX 64  // and /mst
+#define MIDI_OUT_MAX 128  // bytes in one /midiout
+uint32_t frame_tick = 0;  // timer_ticks when the last /nf came in, event ticks are relative to this
+#ifdef DEBUG
+uint32_t nf_rx_micros;    // when the last /nf finished arriving, for latency.h
+uint32_t key_edge_micros[10];   // when each key first read different from its debounced state
+uint16_t key_edge_pending = 0;  // bit per key, the time above is waiting on its event
+#endif
+
+// set by /save, the main loop then writes the changed settings to flash
+uint8_t config_save = 0;
+uint32_t config_overruns = 0;   // host overruns during a /save (the host should be quiet)
 
 
 // ADC DMA stuff
 #define ADC1_DR_Address    0x40012440
 __IO uint16_t RegularConvData_Tab[9];
 
+// knobs are sampled on a TIM3 trigger rather than free running,
+// each trigger converts the whole 6 channel sequence once,
+// so this is the per channel rate (and the rate DMA TC gets set)
+#define ADC_SAMPLE_RATE_HZ 1000
+#define ADC_TIM_CLOCK_HZ 1000000   // TIM3 counts at 1 MHz after the prescaler
+
 // keys and knobs
 uint8_t keyValuesRaw[10];
 uint8_t keyValues[4][10];
 uint8_t keyValuesLast[10];
 uint32_t knobValues[6];
 
+// knob reporting rate
+// 0 (default): knobs only go out once per frame as /knobs, with the MIDI
+// > 0: knobs go out as /kt while they move, at most this many per second,
+//      and nothing at all is sent while they sit still
+// /kt is <timestamp us> followed by <knob> <value> pairs for the knobs that moved.
+// on the wire (SLIP framed, 10 bits per byte at 500k) at 200 Hz:
+//   one knob swept     26 bytes,  5.2 kB/s,  ~10% of the link
+//   two knobs swept    34 bytes,  6.8 kB/s,  ~14%
+//   all five swept     66 bytes, 13.2 kB/s,  ~26%
+//   knobs idle          0 bytes  (frame mode /knobs is 42 bytes every frame)
+#define KNOB_REPORT_RATE_MAX 1000
+#define KNOB_DEADBAND 3   // ADC counts a knob must move before it gets reported
+uint32_t knob_report_rate = 0;
+uint32_t knobValuesSent[5];
+
+// response curve for each knob (curves.h), applied to what goes out
+uint8_t knobCurve[5] = {CURVE_LINEAR, CURVE_LINEAR, CURVE_LINEAR, CURVE_LINEAR, CURVE_LINEAR};
+
 // current LED color
 // set in the OSC callback, so it can then be flashed
 // a different color (for midi and foot switch)
@@ -50,6 +103,45 @@ extern uint32_t led_flash_countdown;
 uint8_t led_override = 0;
 uint8_t foot_down = 0;
 
+// foot input, either a switch (/fs) or an expression pedal (/exp)
+// in auto mode it is a switch until the input is seen resting between
+// the switch thresholds, which a switch never does
+#define FOOT_MODE_AUTO 0
+#define FOOT_MODE_SWITCH 1
+#define FOOT_MODE_EXPRESSION 2
+#define FOOT_SWITCH_LOW 100
+#define FOOT_SWITCH_HIGH 900
+#define FOOT_DEBOUNCE_TICKS 100    // 10 ms stable before a switch change counts
+#define FOOT_DETECT_TICKS 2500     // 250 ms resting mid range means a pedal
+#define FOOT_CAL_MIN_SPAN 64       // pedal has to sweep this much before it reports
+#define FOOT_EXP_DEADBAND 4
+uint8_t foot_mode = FOOT_MODE_AUTO;
+uint8_t foot_expression = 0;   // set when a pedal is detected or configured
+int32_t foot_filtered = -1;    // smoothed foot input, 4 fractional bits, -1 until first sample
+uint32_t foot_cal_min;
+uint32_t foot_cal_max;
+uint32_t foot_mid_since;       // when the input was last seen outside the pedal range
+uint32_t foot_exp_sent;        // last /exp value, out of range after a reset so the next one goes
+
+// OLED (ssd1306.c), build with CONFIG_OLED defined for boards that have one.
+// the display header uses PA5 / PA7 (SPI1) and PA8 - PA10 (RST, DC, CS),
+// the same lines as keys 1 - 5, so it is one or the other
+//
+// the host draws with /oled/... (oledText() and friends below), everything
+// lands in pix_buf and only the changed columns go out to the panel.
+// on the wire (SLIP framed, 10 bits per byte at 500k):
+//   /oled/text 0 48 "Cutoff 64"         42 bytes, 0.8 ms
+//   /oled/fill to blank that line        42 bytes
+//   /oled/xor a 12 column change         42 bytes (XOR delta, RLE)
+//   /oled/clear                          18 bytes
+//   /oled/rle blank screen               42 bytes (8 runs)
+//   full bitmap, nothing repeats       ~1100 bytes in 6 messages, 22 ms
+#ifdef CONFIG_OLED
+#define OLED_VCC SSD1306_SWITCHCAPVCC
+#define OLED_TEXT_MAX 32    // characters in one /oled/text
+#define OLED_BLOB_MAX 200   // RLE bytes in one /oled/rle or /oled/xor, inside the 256 byte SLIP buffer
+#endif
+
 // OSC stuff
 SLIPEncodedSerial slip;
 SimpleWriter oscBuf;
@@ -57,6 +149,7 @@ SimpleWriter oscBuf;
 //// hardware init
 static void ADC_Config(void);
 static void DMA_Config(void);
+static void TIM_Config(void);
 void hardwareInit(void);
 
 // OSC callbacks
@@ -64,30 +157,87 @@ void hardwareInit(void);
 // ETC sends a newFrame message before rendering a new frame.
 // then we wait 20ms or so to allow MIDI to accumulate before sending it back
 // this will arrive just in time for the next frame
+void dispatchMessage(OSCMessage &msg);
+void runScheduled(void);
 void ledControl(OSCMessage &msg);
 void shutdown(OSCMessage &msg);
 void newFrame(OSCMessage &msg);
 void midiChannelUpdate(OSCMessage &msg);
+void midiChannelMaskUpdate(OSCMessage &msg);
+void knobRateUpdate(OSCMessage &msg);
+void footModeUpdate(OSCMessage &msg);
+void knobCurveUpdate(OSCMessage &msg);
+void curveTableUpdate(OSCMessage &msg);
+void configSave(OSCMessage &msg);
+void midiModeUpdate(OSCMessage &msg);
+void midiThruUpdate(OSCMessage &msg);
+void replyLeadUpdate(OSCMessage &msg);
+void midiOut(OSCMessage &msg);
+void timeSync(OSCMessage &msg);
+void timeSyncSet(OSCMessage &msg);
+void atSchedule(OSCMessage &msg);
+void atClear(OSCMessage &msg);
+void stats(OSCMessage &msg);
+void statsPool(OSCMessage &msg);
+void statsFrame(OSCMessage &msg);
+void statsSched(OSCMessage &msg);
+#ifdef DEBUG
+void statsISR(OSCMessage &msg);
+void statsLatency(OSCMessage &msg);
+void statsLatencyClear(OSCMessage &msg);
+void statsLoop(OSCMessage &msg);
+void statsLoopClear(OSCMessage &msg);
+#ifdef TRACE
+void statsLoopTrace(OSCMessage &msg);
+#endif
+#endif
+#ifdef CONFIG_OLED
+void oledClear(OSCMessage &msg);
+void oledFill(OSCMessage &msg);
+void oledText(OSCMessage &msg);
+void oledRLE(OSCMessage &msg);
+void oledXOR(OSCMessage &msg);
+void oledStats(OSCMessage &msg);
+#endif
 // end OSC callbacks
 
 // for sending OSC back (knobs and MIDI,  the keys and fs get sent when they change on poll)
 void sendKnobs(void);
 void sendMIDI(void);
+void sendMIDIEvents(void);
+void sendMIDIControllers(void);
+void sendMIDIState(void);
+void sendMIDIClock(void);
 
 /// scan keys
 uint32_t scanKeys();
 void remapKeys();
 void checkForKeyEvent();
 void updateKnobs() ;
+void checkKnobMotion(void);
 
 //foot
 void checkFootSwitch (void) ;
+void checkExpressionPedal(void);
+void resetFootCalibration(void);
 
 // led helper
 void setLED(int stat);
 
+// settings, these are kept in flash (config.h) so they survive a power cycle
+void loadSettings(void);
+void applySetting(uint8_t key, uint16_t value);
+void changeSetting(uint8_t key, uint16_t value);
+uint8_t validSetting(uint8_t key, uint16_t value);
+
+// SysEx from MIDI in, ours changes settings, the rest goes to the host
+void checkSysex(void);
+
 int main(int argc, char* argv[]) {
 
+	// free RAM gets painted before anything else runs so /stats sees the real stack peak
+	memstats_paint();
+
 	OSCMessage msgIn;
 
 	blink_led_init();
@@ -119,6 +269,17 @@ int main(int argc, char* argv[]) {
 
 	midi_init(1);
 
+#ifdef CONFIG_OLED
+	// after hardwareInit so the display takes the key lines over
+	ssd1306_init(OLED_VCC);
+#endif
+
+	resetFootCalibration();
+
+	// get the saved settings before the handshake so the host doesn't have to resend them
+	config_init();
+	loadSettings();
+
 	int progress = 0;
 
 	stopwatchStart();
@@ -157,14 +318,17 @@ int main(int argc, char* argv[]) {
 
 	stopwatchStart();   // used to check encoder only 1 per 5 ms
 
+#ifdef DEBUG
+	loopprof_clear();
+#endif
+
 	while (1) {
+		LOOPPROF_BEGIN();
 
-		// check for midi,  new midi stuff gets put in the midi_blob
-		while (uart1_recv_buf_tail != uart1_recv_buf_head) {
-			uint8_t tmp8 = uart1_recv_buf[uart1_recv_buf_tail++];
-			uart1_recv_buf_tail %= UART1_BUFFER_SIZE;
-			recvByte(tmp8);
-		} // gettin MIDI bytes
+		// MIDI is parsed in the USART1 ISR, the frame gets picked up below
+
+		// anything from /at that is due, first so an /led lands on this pass
+		runScheduled();
 
 		// flash LED with new midi
 		if (new_midi_flag){
@@ -187,45 +351,83 @@ int main(int argc, char* argv[]) {
 		}
 		// otherwise the OSC color
 		else { setLED(ledColor);}
-
-
+		LOOPPROF_MARK(LOOP_SCHED);
 
 		if (slip.recvMessage()) {
+			if (slip.decodedLength > slip_msg_peak) slip_msg_peak = slip.decodedLength;
+
 			// fill the message and dispatch it
 
 			msgIn.fill(slip.decodedBuf, slip.decodedLength);
 
 			// dispatch it
 			if (!msgIn.hasError()) {
-				msgIn.dispatch("/led", ledControl, 0);
-				msgIn.dispatch("/shutdown", shutdown, 0);
-				msgIn.dispatch("/nf", newFrame, 0);
-				msgIn.dispatch("/midich", midiChannelUpdate, 0);
+				dispatchMessage(msgIn);
 				msgIn.empty();
 			} else {   // just empty it if there was an error
 				msgIn.empty();
 			}
 		}
+		LOOPPROF_MARK(LOOP_HOST_RX);
 
 		// every time mux gets back to 0 key scan is complete
 		scanKeys();
 		checkForKeyEvent(); // and send em out if we got em
+		LOOPPROF_MARK(LOOP_KEYS);
 
 		// also check about the foot switch
 		checkFootSwitch();
+		LOOPPROF_MARK(LOOP_FOOT);
+
+		// anything come in by SysEx
+		checkSysex();
+		LOOPPROF_MARK(LOOP_SYSEX);
+
+#ifdef CONFIG_OLED
+		// push whatever got drawn, the transfers run by DMA while the loop goes on
+		ssd1306_poll();
+#endif
+		LOOPPROF_MARK(LOOP_OLED);
 
 		// get the values from DMA
 		updateKnobs();
-
-		// the /nf (newFrame) osc message restarts stop watch
-		// after 25 ms towards the end of the frame, send the midi_blob back
-		if (stopwatchReport() > 250){
-			if (!midi_blob_sent) {
-				sendMIDI();
-				sendKnobs();
-				midi_blob_sent = 1;
-			}
+		LOOPPROF_MARK(LOOP_KNOBS);
+
+		// send moving knobs right away if not waiting for the frame
+		checkKnobMotion();
+		LOOPPROF_MARK(LOOP_KNOB_TX);
+
+		// towards the end of the frame (frametime.h works out when), send the midi_blob back
+		if (!midi_blob_sent && frametime_reply_due(timer_micros())) {
+			LATENCY(LAT_NF_REPLY_START, nf_rx_micros, timer_micros());
+			midi_frame_swap();
+			if (midi_mode & MIDI_MODE_SNAPSHOT) sendMIDI();
+			if (midi_mode & MIDI_MODE_EVENTS) sendMIDIEvents();
+			if (midi_mode & MIDI_MODE_CC) sendMIDIControllers();
+			if (midi_mode & MIDI_MODE_STATE) sendMIDIState();
+			if (midi_mode & MIDI_MODE_CLOCK) sendMIDIClock();
+			if (!knob_report_rate) sendKnobs();
+			midi_blob_sent = 1;
+			frametime_replied(timer_micros());
+			LATENCY(LAT_NF_REPLY_DONE, nf_rx_micros, timer_micros());
+		}
+		LOOPPROF_MARK(LOOP_REPLY);
+
+		// flash writes stall the CPU, interrupts included (~20 ms for a page erase), and
+		// the serial ports drop bytes while they do.  so they only happen on a /save,
+		// after which the host sends nothing until the /save reply comes back
+		if (config_save) {
+			uint32_t overruns = uart2_overruns;
+			while (config_pending()) config_poll();
+			config_save = 0;
+			config_overruns += uart2_overruns - overruns;
+
+			OSCMessage msgSave("/save");
+			msgSave.send(oscBuf);
+			slip.sendMessage(oscBuf.buffer, oscBuf.length);
+			msgSave.empty();
 		}
+		LOOPPROF_MARK(LOOP_FLASH);
 
 	} // Infinite loop, never return.
 }
@@ -238,6 +440,9 @@ void hardwareInit(void){
 	/* ADC1 configuration */
 	ADC_Config();
 
+	/* TIM3 configuration, starts the conversions */
+	TIM_Config();
+
 	// key lines
 	GPIO_InitTypeDef GPIO_InitStructure;
 	GPIO_StructInit(&GPIO_InitStructure);
@@ -307,21 +512,24 @@ static void ADC_Config(void) {
 	/* Initialize ADC structure */
 	ADC_StructInit(&ADC_InitStructure);
 
-	/* Configure the ADC1 in continuous mode withe a resolution equal to 12 bits  */
+	/* Configure the ADC1 with a resolution equal to 10 bits,
+	 * one scan of the sequence per TIM3 TRGO rising edge  */
 	ADC_InitStructure.ADC_Resolution = ADC_Resolution_10b;
-	ADC_InitStructure.ADC_ContinuousConvMode = ENABLE;
-	ADC_InitStructure.ADC_ExternalTrigConvEdge = ADC_ExternalTrigConvEdge_None;
+	ADC_InitStructure.ADC_ContinuousConvMode = DISABLE;
+	ADC_InitStructure.ADC_ExternalTrigConvEdge = ADC_ExternalTrigConvEdge_Rising;
+	ADC_InitStructure.ADC_ExternalTrigConv = ADC_ExternalTrigConv_T3_TRGO;
 	ADC_InitStructure.ADC_DataAlign = ADC_DataAlign_Right;
 	ADC_InitStructure.ADC_ScanDirection = ADC_ScanDirection_Backward;
 	ADC_Init(ADC1, &ADC_InitStructure);
 
-	/* Convert the ADC1 Channel11 and channel10 with 55.5 Cycles as sampling time */
-	ADC_ChannelConfig(ADC1, ADC_Channel_14, ADC_SampleTime_55_5Cycles);
-	ADC_ChannelConfig(ADC1, ADC_Channel_15, ADC_SampleTime_55_5Cycles);
-	ADC_ChannelConfig(ADC1, ADC_Channel_4, ADC_SampleTime_55_5Cycles);
-	ADC_ChannelConfig(ADC1, ADC_Channel_8, ADC_SampleTime_55_5Cycles);
-	ADC_ChannelConfig(ADC1, ADC_Channel_9, ADC_SampleTime_55_5Cycles);
-	ADC_ChannelConfig(ADC1, ADC_Channel_1, ADC_SampleTime_55_5Cycles);
+	/* Convert the knob channels with 239.5 Cycles as sampling time,
+	 * 6 x 252 cycles at 14 MHz is ~110 us, well inside one trigger period */
+	ADC_ChannelConfig(ADC1, ADC_Channel_14, ADC_SampleTime_239_5Cycles);
+	ADC_ChannelConfig(ADC1, ADC_Channel_15, ADC_SampleTime_239_5Cycles);
+	ADC_ChannelConfig(ADC1, ADC_Channel_4, ADC_SampleTime_239_5Cycles);
+	ADC_ChannelConfig(ADC1, ADC_Channel_8, ADC_SampleTime_239_5Cycles);
+	ADC_ChannelConfig(ADC1, ADC_Channel_9, ADC_SampleTime_239_5Cycles);
+	ADC_ChannelConfig(ADC1, ADC_Channel_1, ADC_SampleTime_239_5Cycles);
 
 	/* ADC Calibration */
 	ADC_GetCalibrationFactor(ADC1);
@@ -339,10 +547,37 @@ static void ADC_Config(void) {
 	while (!ADC_GetFlagStatus(ADC1, ADC_FLAG_ADRDY))
 		;
 
-	/* ADC1 regular Software Start Conv */
+	/* ADC1 regular Start Conv, with a trigger selected this just arms it
+	 * and the conversions start on the TIM3 update events */
 	ADC_StartOfConversion(ADC1);
 }
 
+/**
+ * @brief  TIM3 configuration, update event on TRGO triggers the ADC
+ * @param  None
+ * @retval None
+ */
+static void TIM_Config(void) {
+	TIM_TimeBaseInitTypeDef TIM_TimeBaseStructure;
+
+	/* TIM3 clock enable */
+	RCC_APB1PeriphClockCmd(RCC_APB1Periph_TIM3, ENABLE);
+
+	TIM_DeInit(TIM3);
+	TIM_TimeBaseStructInit(&TIM_TimeBaseStructure);
+	TIM_TimeBaseStructure.TIM_Prescaler = (SystemCoreClock / ADC_TIM_CLOCK_HZ) - 1;
+	TIM_TimeBaseStructure.TIM_Period = (ADC_TIM_CLOCK_HZ / ADC_SAMPLE_RATE_HZ) - 1;
+	TIM_TimeBaseStructure.TIM_CounterMode = TIM_CounterMode_Up;
+	TIM_TimeBaseStructure.TIM_ClockDivision = 0;
+	TIM_TimeBaseInit(TIM3, &TIM_TimeBaseStructure);
+
+	/* TIM3 TRGO selection */
+	TIM_SelectOutputTrigger(TIM3, TIM_TRGOSource_Update);
+
+	/* TIM3 enable counter */
+	TIM_Cmd(TIM3, ENABLE);
+}
+
 /**
  * @brief  DMA channel1 configuration
  * @param  None
@@ -376,15 +611,129 @@ static void DMA_Config(void) {
 
 //// end ADC DMA
 
+// everything the host can send once it is running, from the serial port or from /at
+void dispatchMessage(OSCMessage &msg){
+	msg.dispatch("/led", ledControl, 0);
+	msg.dispatch("/shutdown", shutdown, 0);
+	msg.dispatch("/nf", newFrame, 0);
+	msg.dispatch("/midich", midiChannelUpdate, 0);
+	msg.dispatch("/midichmask", midiChannelMaskUpdate, 0);
+	msg.dispatch("/knobrate", knobRateUpdate, 0);
+	msg.dispatch("/fsmode", footModeUpdate, 0);
+	msg.dispatch("/curve", knobCurveUpdate, 0);
+	msg.dispatch("/curvetable", curveTableUpdate, 0);
+	msg.dispatch("/save", configSave, 0);
+	msg.dispatch("/midimode", midiModeUpdate, 0);
+	msg.dispatch("/midithru", midiThruUpdate, 0);
+	msg.dispatch("/midiout", midiOut, 0);
+	msg.dispatch("/replylead", replyLeadUpdate, 0);
+	msg.dispatch("/sync", timeSync, 0);
+	msg.dispatch("/sync/set", timeSyncSet, 0);
+	msg.dispatch("/at", atSchedule, 0);
+	msg.dispatch("/at/clear", atClear, 0);
+	msg.dispatch("/stats", stats, 0);
+	msg.dispatch("/stats/pool", statsPool, 0);
+	msg.dispatch("/stats/frame", statsFrame, 0);
+	msg.dispatch("/stats/sched", statsSched, 0);
+#ifdef DEBUG
+	msg.dispatch("/stats/isr", statsISR, 0);
+	msg.dispatch("/stats/latency", statsLatency, 0);
+	msg.dispatch("/stats/latency/clear", statsLatencyClear, 0);
+	msg.dispatch("/stats/loop", statsLoop, 0);
+	msg.dispatch("/stats/loop/clear", statsLoopClear, 0);
+#ifdef TRACE
+	msg.dispatch("/stats/loop/trace", statsLoopTrace, 0);
+#endif
+#endif
+#ifdef CONFIG_OLED
+	msg.dispatch("/oled/clear", oledClear, 0);
+	msg.dispatch("/oled/fill", oledFill, 0);
+	msg.dispatch("/oled/text", oledText, 0);
+	msg.dispatch("/oled/rle", oledRLE, 0);
+	msg.dispatch("/oled/xor", oledXOR, 0);
+	msg.dispatch("/oled/stats", oledStats, 0);
+#endif
+}
+
 // OSC callbacks
 void newFrame(OSCMessage &msg){
+	frametime_nf(timer_micros());
+#ifdef DEBUG
+	nf_rx_micros = slip.rxMicros;
+	LATENCY(LAT_NF_DISPATCH, nf_rx_micros, timer_micros());
+#endif
 	midi_blob_sent = 0;
-	stopwatchStart();  // start timer on new frame, when it gets to 25 ms
+	frame_tick = timer_ticks;
 }
 
 void midiChannelUpdate(OSCMessage &msg){
 	if (msg.isInt(0)) {
-		channelIn_ = msg.getInt(0);
+		int32_t ch = msg.getInt(0);
+
+		if ((ch < 0) || (ch > 16)) return;
+		changeSetting(CONFIG_MIDI_CHANNEL_MASK, ch ? (1 << (ch - 1)) : 0xFFFF);
+	}
+}
+
+// /midichmask <mask>, bit 0 is channel 1 ... bit 15 channel 16
+void midiChannelMaskUpdate(OSCMessage &msg){
+	if (msg.isInt(0)) {
+		int32_t mask = msg.getInt(0);
+
+		if ((mask <= 0) || (mask > 0xFFFF)) return;
+		changeSetting(CONFIG_MIDI_CHANNEL_MASK, mask);
+	}
+}
+
+void knobRateUpdate(OSCMessage &msg){
+	if (msg.isInt(0)) {
+		int32_t rate = msg.getInt(0);
+
+		if (rate < 0) rate = 0;
+		if (rate > KNOB_REPORT_RATE_MAX) rate = KNOB_REPORT_RATE_MAX;
+		changeSetting(CONFIG_KNOB_RATE, rate);
+	}
+}
+
+void footModeUpdate(OSCMessage &msg){
+	if (msg.isInt(0)) {
+		int32_t mode = msg.getInt(0);
+
+		if ((mode < FOOT_MODE_AUTO) || (mode > FOOT_MODE_EXPRESSION)) return;
+		changeSetting(CONFIG_FOOT_MODE, mode);
+	}
+}
+
+// /curve <knob> <curve>, knob -1 sets them all
+void knobCurveUpdate(OSCMessage &msg){
+	uint32_t i;
+
+	if (msg.isInt(0) && msg.isInt(1)) {
+		int32_t knob = msg.getInt(0);
+		int32_t curve = msg.getInt(1);
+
+		if ((curve < 0) || (curve >= CURVE_COUNT)) return;
+		for (i = 0; i < 5; i++) {
+			if ((knob < 0) || (knob == (int32_t) i)) changeSetting(CONFIG_KNOB_CURVE + i, curve);
+		}
+	}
+}
+
+// /curvetable <first point> <value> <value> ...
+// loads points of the user curve, values 0 - 1023
+void curveTableUpdate(OSCMessage &msg){
+	int32_t i;
+	int32_t point;
+
+	if (!msg.isInt(0)) return;
+	point = msg.getInt(0);
+
+	for (i = 1; i < msg.size(); i++, point++) {
+		if ((point < 0) || (point >= CURVE_POINTS) || !msg.isInt(i)) break;
+		int32_t v = msg.getInt(i);
+		if (v < 0) v = 0;
+		if (v > CURVE_MAX) v = CURVE_MAX;
+		changeSetting(CONFIG_CURVE_USER + point, v);
 	}
 }
 
@@ -406,6 +755,11 @@ void ledControl(OSCMessage &msg) {
 	}
 }
 
+// the write is left to the main loop, see config_save
+void configSave(OSCMessage &msg) {
+	config_save = 1;
+}
+
 void shutdown(OSCMessage &msg) {
 
 	int i;
@@ -438,6 +792,475 @@ void shutdown(OSCMessage &msg) {
 
 // end OSC callbacks
 
+// /midimode <bits>, any of MIDI_MODE_SNAPSHOT (1), MIDI_MODE_EVENTS (2), MIDI_MODE_CC (4),
+// MIDI_MODE_STATE (8), MIDI_MODE_CLOCK (16)
+void midiModeUpdate(OSCMessage &msg){
+	if (msg.isInt(0)) {
+		int32_t mode = msg.getInt(0);
+
+		if ((mode < 0) || (mode > (MIDI_MODE_SNAPSHOT | MIDI_MODE_EVENTS | MIDI_MODE_CC | MIDI_MODE_STATE | MIDI_MODE_CLOCK))) return;
+		changeSetting(CONFIG_MIDI_MODE, mode);
+	}
+}
+
+// /midithru <bits>, what goes from MIDI in to MIDI out, see MIDI_THRU_* in midi.h
+void midiThruUpdate(OSCMessage &msg){
+	if (msg.isInt(0)) {
+		int32_t mask = msg.getInt(0);
+
+		if ((mask < 0) || (mask > 0x1F)) return;
+		changeSetting(CONFIG_MIDI_THRU, mask);
+	}
+}
+
+// /replylead <percent>, how far ahead of the next /nf the frame reply goes, as a
+// percent of the frame interval.  more lead is more margin for a late reply but
+// older knob and MIDI data, the default 25 is the old fixed 25 ms at 30 fps
+void replyLeadUpdate(OSCMessage &msg){
+	if (msg.isInt(0)) {
+		int32_t lead = msg.getInt(0);
+
+		if ((lead < 0) || (lead > FRAMETIME_LEAD_MAX)) return;
+		changeSetting(CONFIG_REPLY_LEAD, lead);
+	}
+}
+
+// copies blob argument idx into buf without the length OSC keeps in front of it,
+// returns the length, 0 if it isn't a blob, is empty or is longer than max
+int blobArg(OSCMessage &msg, int idx, uint8_t * buf, int max){
+	OSCData * datum;
+	int len;
+
+	if (!msg.isBlob(idx)) return 0;
+	datum = msg.getOSCData(idx);
+	len = datum->bytes - 4;
+	if ((len <= 0) || (len > max)) return 0;
+
+	memcpy(buf, datum->data.b + 4, len);
+	return len;
+}
+
+// /midiout <blob>, raw MIDI bytes to send, complete messages starting with a status
+void midiOut(OSCMessage &msg){
+	uint8_t bytes[MIDI_OUT_MAX];
+	int len;
+
+	len = blobArg(msg, 0, bytes, sizeof(bytes));
+	if (len) midi_send_raw(bytes, len);
+}
+
+// clock sync, NTP style.  the host sends /sync <id> at its time t1, this answers
+// /sync <id> <t2> <t3>, controller time (timer_micros64()) as timetags, t2 when the
+// request finished arriving (stamped in the USART ISR) and t3 as the reply goes out.
+// with t4 when the reply arrives the host has
+//   offset = ((t2 - t1) + (t3 - t4)) / 2    round trip = (t4 - t1) - (t3 - t2)
+// and the drift from how the offset moves over a few of these.  it sends the
+// result back with /sync/set so oscTime() and friends give host time
+void timeSync(OSCMessage &msg){
+	OSCMessage msgSync("/sync");
+	osctime_t t;
+	uint64_t now = timer_micros64();
+	uint64_t rx = now - (uint32_t) ((uint32_t) now - slip.rxMicros);
+
+	msgSync.add((int32_t) (msg.isInt(0) ? msg.getInt(0) : 0));
+	timesync_to_ntp(rx, &t.seconds, &t.fractionofseconds);
+	msgSync.add(t);
+	msgSync.add(t);    // t3, filled in below
+	msgSync.send(oscBuf);
+
+	// t3 is the last 8 bytes, written straight into the packet at the last moment
+	timesync_to_ntp(timer_micros64(), &t.seconds, &t.fractionofseconds);
+	oscBuf.buffer[oscBuf.length - 8] = t.seconds >> 24;
+	oscBuf.buffer[oscBuf.length - 7] = t.seconds >> 16;
+	oscBuf.buffer[oscBuf.length - 6] = t.seconds >> 8;
+	oscBuf.buffer[oscBuf.length - 5] = t.seconds;
+	oscBuf.buffer[oscBuf.length - 4] = t.fractionofseconds >> 24;
+	oscBuf.buffer[oscBuf.length - 3] = t.fractionofseconds >> 16;
+	oscBuf.buffer[oscBuf.length - 2] = t.fractionofseconds >> 8;
+	oscBuf.buffer[oscBuf.length - 1] = t.fractionofseconds;
+	slip.sendMessage(oscBuf.buffer, oscBuf.length);
+	msgSync.empty();
+}
+
+// <controller time> <host time at that controller time> [drift ppb], times are timetags
+void timeSyncSet(OSCMessage &msg){
+	osctime_t ctrl, host;
+
+	if (!msg.isTime(0) || !msg.isTime(1)) return;
+	ctrl = msg.getTime(0);
+	host = msg.getTime(1);
+	timesync_set(timesync_from_ntp(ctrl.seconds, ctrl.fractionofseconds),
+			timesync_from_ntp(host.seconds, host.fractionofseconds),
+			msg.isInt(2) ? msg.getInt(2) : 0);
+}
+
+// /at <timetag> <blob>, the blob is a whole OSC message (address, type tags, args)
+// that gets dispatched when the time comes, as if it came in then.  the time is host
+// time once /sync/set has been sent (controller time before), "immediately" runs it
+// on the next loop pass.  it goes at the first loop pass after its time, so it is late
+// by up to one pass, more if that pass is sending a frame reply (see /stats/sched)
+void atSchedule(OSCMessage &msg){
+	uint8_t bytes[SCHED_MSG_MAX];
+	osctime_t t;
+	uint64_t now, at;
+	int len;
+
+	if (!msg.isTime(0)) return;
+	len = blobArg(msg, 1, bytes, sizeof(bytes));
+	if (!len) return;
+
+	// no /at inside /at, it could keep itself going forever.  just /at itself,
+	// /at/clear can be scheduled
+	if (bytes[0] != '/') return;
+	if ((len >= 4) && !memcmp(bytes, "/at", 4)) return;
+
+	now = timer_micros64();
+	t = msg.getTime(0);
+	if ((t.seconds == 0) && (t.fractionofseconds == 1)) at = now;
+	else at = timesync_ctrl_micros(timesync_from_ntp(t.seconds, t.fractionofseconds));
+	sched_add(at, now, bytes, len);
+}
+
+// drop everything waiting
+void atClear(OSCMessage &msg){
+	sched_clear();
+}
+
+void runScheduled(void){
+	uint8_t * bytes;
+	uint8_t len;
+
+	if (!sched_pending()) return;
+
+	OSCMessage msgAt;
+	while ((len = sched_get(timer_micros64(), &bytes))) {
+		// it comes in now, /sync's t2 and /nf's latency go from here and not
+		// from whatever the host sent last
+		slip.rxMicros = timer_micros();
+		msgAt.fill(bytes, len);
+		if (!msgAt.hasError()) dispatchMessage(msgAt);
+		msgAt.empty();
+		sched_release();
+	}
+}
+
+// <run> <queued> <peak queued> <late avg> <late max> <turned away full> <already past on arrival>,
+// lateness in us after the time asked for
+void statsSched(OSCMessage &msg){
+	OSCMessage msgStats("/stats/sched");
+	sched_stats_t stats;
+
+	sched_stats(&stats);
+	msgStats.add((int32_t) stats.run);
+	msgStats.add((int32_t) stats.queued);
+	msgStats.add((int32_t) stats.peak);
+	msgStats.add((int32_t) stats.late_avg);
+	msgStats.add((int32_t) stats.late_max);
+	msgStats.add((int32_t) stats.full);
+	msgStats.add((int32_t) stats.past);
+	msgStats.send(oscBuf);
+	slip.sendMessage(oscBuf.buffer, oscBuf.length);
+	msgStats.empty();
+}
+
+// memory and buffer use since boot:
+// <stack peak> <stack size> <heap peak> <heap size> <untouched RAM> <heap failures>
+// <OSC pool failures> <host rx peak> <host rx overruns> <MIDI out peak> <MIDI out dropped>
+// <longest host message> <host overruns during /save> <host rx dropped>, sizes in bytes
+void stats(OSCMessage &msg){
+	OSCMessage msgStats("/stats");
+	memstats_t mem;
+
+	memstats_get(&mem);
+	msgStats.add((int32_t) mem.stack_peak);
+	msgStats.add((int32_t) mem.stack_size);
+	msgStats.add((int32_t) mem.heap_peak);
+	msgStats.add((int32_t) mem.heap_size);
+	msgStats.add((int32_t) mem.untouched);
+	msgStats.add((int32_t) mem.heap_failures);
+	msgStats.add((int32_t) osc_pool_failures());
+	msgStats.add((int32_t) uart2_recv_peak);
+	msgStats.add((int32_t) uart2_overruns);
+	msgStats.add((int32_t) uart1_send_peak);
+	msgStats.add((int32_t) uart1_send_dropped);
+	msgStats.add((int32_t) slip_msg_peak);
+	msgStats.add((int32_t) config_overruns);
+	msgStats.add((int32_t) uart2_recv_dropped);
+	msgStats.send(oscBuf);
+	slip.sendMessage(oscBuf.buffer, oscBuf.length);
+	msgStats.empty();
+}
+
+// frame reply timing, times in us: <interval> <jitter> <reply delay> <slack> <min slack> <late> <frames>
+// slack is how far ahead of the next /nf the reply finished, min slack is since the last /stats/frame
+// and late counts frames where the next /nf beat the reply
+void statsFrame(OSCMessage &msg){
+	OSCMessage msgStats("/stats/frame");
+	frametime_stats_t stats;
+
+	frametime_stats(&stats);
+	msgStats.add((int32_t) stats.interval);
+	msgStats.add((int32_t) stats.jitter);
+	msgStats.add((int32_t) stats.delay);
+	msgStats.add((int32_t) stats.slack);
+	msgStats.add((int32_t) stats.slack_min);
+	msgStats.add((int32_t) stats.late);
+	msgStats.add((int32_t) stats.frames);
+	msgStats.send(oscBuf);
+	slip.sendMessage(oscBuf.buffer, oscBuf.length);
+	msgStats.empty();
+}
+
+#ifdef DEBUG
+// handler cycles, last and worst: <host rx> <host rx max> <MIDI rx> <MIDI rx max> <SysTick> <SysTick max>
+void statsISR(OSCMessage &msg){
+	OSCMessage msgStats("/stats/isr");
+	msgStats.add((int32_t) isr_cycles_host.last);
+	msgStats.add((int32_t) isr_cycles_host.max);
+	msgStats.add((int32_t) isr_cycles_midi.last);
+	msgStats.add((int32_t) isr_cycles_midi.max);
+	msgStats.add((int32_t) isr_cycles_tick.last);
+	msgStats.add((int32_t) isr_cycles_tick.max);
+	msgStats.send(oscBuf);
+	slip.sendMessage(oscBuf.buffer, oscBuf.length);
+	msgStats.empty();
+}
+#endif
+
+#ifdef DEBUG
+// /stats/latency, <count> <mean> <max> for each probe (latency.h), times in us
+// /stats/latency <probe>, <probe> <count> <mean> <max> and the bucket counts
+void statsLatency(OSCMessage &msg){
+	OSCMessage msgStats("/stats/latency");
+	latency_probe_t stats;
+	uint8_t i, b;
+
+	if (msg.isInt(0)) {
+		if ((msg.getInt(0) < 0) || (msg.getInt(0) >= LAT_PROBES)) return;
+		i = msg.getInt(0);
+		latency_get(i, &stats);
+		msgStats.add((int32_t) i);
+		msgStats.add((int32_t) stats.count);
+		msgStats.add((int32_t) (stats.count ? stats.total / stats.count : 0));
+		msgStats.add((int32_t) stats.max);
+		for (b = 0; b < LAT_BUCKETS; b++) msgStats.add((int32_t) stats.buckets[b]);
+	}
+	else {
+		for (i = 0; i < LAT_PROBES; i++) {
+			latency_get(i, &stats);
+			msgStats.add((int32_t) stats.count);
+			msgStats.add((int32_t) (stats.count ? stats.total / stats.count : 0));
+			msgStats.add((int32_t) stats.max);
+		}
+	}
+	msgStats.send(oscBuf);
+	slip.sendMessage(oscBuf.buffer, oscBuf.length);
+	msgStats.empty();
+}
+
+void statsLatencyClear(OSCMessage &msg){
+	latency_clear();
+}
+
+// main loop, in cycles (48 per us): <passes> then <min> <mean> <max> for each stage
+// (loopprof.h, in loop order) and last for the whole pass
+void statsLoop(OSCMessage &msg){
+	OSCMessage msgStats("/stats/loop");
+	loopprof_stage_t stats;
+	uint8_t i;
+
+	msgStats.add((int32_t) loopprof_passes());
+	for (i = 0; i <= LOOP_STAGES; i++) {
+		loopprof_get(i, &stats);
+		msgStats.add((int32_t) stats.min);
+		msgStats.add((int32_t) stats.mean);
+		msgStats.add((int32_t) stats.max);
+	}
+	msgStats.send(oscBuf);
+	slip.sendMessage(oscBuf.buffer, oscBuf.length);
+	msgStats.empty();
+}
+
+void statsLoopClear(OSCMessage &msg){
+	loopprof_clear();
+}
+
+#ifdef TRACE
+// the same table out the trace channel, see loopprof.h
+void statsLoopTrace(OSCMessage &msg){
+	loopprof_trace();
+}
+#endif
+#endif
+
+// OSC allocator use, <size> <count> <live> <peak> for each pool, then <fallbacks> <failures>
+void statsPool(OSCMessage &msg){
+	OSCMessage msgStats("/stats/pool");
+	osc_pool_stats_t stats;
+	uint8_t i;
+
+	for (i = 0; i < OSC_POOL_CLASSES; i++) {
+		osc_pool_stats(i, &stats);
+		msgStats.add((int32_t) stats.size);
+		msgStats.add((int32_t) stats.count);
+		msgStats.add((int32_t) stats.live);
+		msgStats.add((int32_t) stats.peak);
+	}
+	msgStats.add((int32_t) osc_pool_fallbacks());
+	msgStats.add((int32_t) osc_pool_failures());
+	msgStats.send(oscBuf);
+	slip.sendMessage(oscBuf.buffer, oscBuf.length);
+	msgStats.empty();
+}
+
+#ifdef CONFIG_OLED
+void oledClear(OSCMessage &msg){
+	ssd1306_clear();
+}
+
+// x y w h on
+void oledFill(OSCMessage &msg){
+	int i;
+	for (i = 0; i < 5; i++) if (!msg.isInt(i)) return;
+	if ((msg.getInt(0) < 0) || (msg.getInt(1) < 0) || (msg.getInt(2) < 0) || (msg.getInt(3) < 0)) return;
+	ssd1306_fill_rect(msg.getInt(0) > 255 ? 255 : msg.getInt(0), msg.getInt(1) > 255 ? 255 : msg.getInt(1),
+			msg.getInt(2) > 255 ? 255 : msg.getInt(2), msg.getInt(3) > 255 ? 255 : msg.getInt(3), msg.getInt(4) ? 1 : 0);
+}
+
+// x y text [font], font is 8 (the 5x8, default) or 16 (arial),
+// only the glyph cells are drawn so clear the line first with /oled/fill if it gets shorter
+void oledText(OSCMessage &msg){
+	char line[OLED_TEXT_MAX + 1];
+	int len, i, font = 8;
+
+	if (!msg.isInt(0) || !msg.isInt(1) || !msg.isString(2)) return;
+	if (msg.isInt(3)) font = msg.getInt(3);
+	if (msg.getDataLength(2) > (int) sizeof(line)) return;
+	msg.getString(2, line, sizeof(line));
+	len = strlen(line);
+
+	if (font == 16) {
+		// the arial table stops at '~'
+		for (i = 0; i < len; i++) if ((line[i] < ' ') || (line[i] > '~')) line[i] = ' ';
+		println_16(line, len, msg.getInt(0), msg.getInt(1));
+	}
+	else println_8(line, len, msg.getInt(0), msg.getInt(1));
+}
+
+// offset blob, offset is page * 128 + column, blob is RLE (ssd1306.h)
+static void oledBlob(OSCMessage &msg, uint8_t flip){
+	uint8_t bytes[OLED_BLOB_MAX];
+	int len;
+
+	if (!msg.isInt(0)) return;
+	if ((msg.getInt(0) < 0) || (msg.getInt(0) >= 1024)) return;
+	len = blobArg(msg, 1, bytes, sizeof(bytes));
+	if (len) ssd1306_put_rle(msg.getInt(0), bytes, len, flip);
+}
+
+void oledRLE(OSCMessage &msg){
+	oledBlob(msg, 0);
+}
+
+// the bytes get XORed into what is on screen, so unchanged parts are runs of 0
+void oledXOR(OSCMessage &msg){
+	oledBlob(msg, 1);
+}
+
+// frames, bytes and time of the last refresh, worst refresh time, total bytes
+void oledStats(OSCMessage &msg){
+	OSCMessage msgStats("/oled/stats");
+	msgStats.add((int32_t) ssd1306_stats.frames);
+	msgStats.add((int32_t) ssd1306_stats.last_bytes);
+	msgStats.add((int32_t) ssd1306_stats.last_us);
+	msgStats.add((int32_t) ssd1306_stats.max_us);
+	msgStats.add((int32_t) ssd1306_stats.total_bytes);
+	msgStats.send(oscBuf);
+	slip.sendMessage(oscBuf.buffer, oscBuf.length);
+	msgStats.empty();
+}
+#endif
+
+// settings
+void loadSettings(void) {
+	uint8_t key;
+	uint16_t value;
+	uint16_t mask;
+
+	// a channel saved by older firmware becomes the mask, unless a mask has been
+	// saved since (that one is newer).  either way the old key is done with
+	if (config_get(CONFIG_MIDI_CHANNEL, &value)) {
+		if (!config_get(CONFIG_MIDI_CHANNEL_MASK, &mask) && (value <= 16))
+			config_set(CONFIG_MIDI_CHANNEL_MASK, value ? (1 << (value - 1)) : 0xFFFF);
+		config_forget(CONFIG_MIDI_CHANNEL);
+	}
+
+	// anything stored by other firmware (or a bad record) that doesn't check out is left alone
+	for (key = 0; key < CONFIG_NUM_KEYS; key++) {
+		if (config_get(key, &value) && validSetting(key, value)) applySetting(key, value);
+	}
+}
+
+// make a setting take effect, values are checked by the caller
+void applySetting(uint8_t key, uint16_t value) {
+	uint32_t i;
+
+	if (key == CONFIG_MIDI_CHANNEL_MASK) {
+		midi_set_channel_mask(value);
+	}
+	else if (key == CONFIG_MIDI_THRU) {
+		midi_thru = value;
+	}
+	else if (key == CONFIG_REPLY_LEAD) {
+		frametime_set_lead(value);
+	}
+	else if (key == CONFIG_KNOB_RATE) {
+		knob_report_rate = value;
+		// out of range so every knob gets reported on the first pass
+		for (i = 0; i < 5; i++) knobValuesSent[i] = 0xFFFF;
+	}
+	else if (key == CONFIG_FOOT_MODE) {
+		foot_mode = value;
+		foot_expression = (foot_mode == FOOT_MODE_EXPRESSION);
+		foot_down = 0;
+		resetFootCalibration();
+	}
+	else if ((key >= CONFIG_KNOB_CURVE) && (key < CONFIG_KNOB_CURVE + 5)) {
+		knobCurve[key - CONFIG_KNOB_CURVE] = value;
+	}
+	else if ((key >= CONFIG_CURVE_USER) && (key < CONFIG_CURVE_USER + CURVE_POINTS)) {
+		curve_user[key - CONFIG_CURVE_USER] = value;
+	}
+	else if (key == CONFIG_MIDI_MODE) {
+		midi_mode = value;
+		// start the list fresh, anything in it now is stale
+		midi_events_clear();
+		// host gets the whole CC table to start from
+		if (midi_mode & MIDI_MODE_CC) midi_cc_mark_all();
+		if (midi_mode & MIDI_MODE_STATE) midi_state_mark_all();
+	}
+}
+
+// for settings that don't come through an OSC handler (SysEx)
+uint8_t validSetting(uint8_t key, uint16_t value) {
+	// CONFIG_MIDI_CHANNEL isn't settable any more, the mask covers it
+	if (key == CONFIG_KNOB_RATE) return (value <= KNOB_REPORT_RATE_MAX);
+	if (key == CONFIG_FOOT_MODE) return (value <= FOOT_MODE_EXPRESSION);
+	if ((key >= CONFIG_KNOB_CURVE) && (key < CONFIG_KNOB_CURVE + 5)) return (value < CURVE_COUNT);
+	if ((key >= CONFIG_CURVE_USER) && (key < CONFIG_CURVE_USER + CURVE_POINTS)) return (value <= CURVE_MAX);
+	if (key == CONFIG_MIDI_MODE) return (value <= (MIDI_MODE_SNAPSHOT | MIDI_MODE_EVENTS | MIDI_MODE_CC | MIDI_MODE_STATE | MIDI_MODE_CLOCK));
+	if (key == CONFIG_MIDI_CHANNEL_MASK) return (value != 0);
+	if (key == CONFIG_MIDI_THRU) return (value <= 0x1F);
+	if (key == CONFIG_REPLY_LEAD) return (value <= FRAMETIME_LEAD_MAX);
+	return 0;
+}
+
+// apply and save for next time
+void changeSetting(uint8_t key, uint16_t value) {
+	applySetting(key, value);
+	config_set(key, value);
+}
+
 // led helper
 void setLED(int stat) {
 	AUX_LED_RED_OFF;
@@ -494,22 +1317,155 @@ void sendMIDI(void) {
 
 	OSCMessage msgMIDI("/mblob"); // blob of midi crap
 
-	msgMIDI.add(midi_blob, 23);
+	msgMIDI.add(midi_front->blob, 23);
 
 	msgMIDI.send(oscBuf);
 	slip.sendMessage(oscBuf.buffer, oscBuf.length);
 	msgMIDI.empty();
 }
 
+// sending the MIDI events since the last reply
+// /mev <dropped> <blob>, the blob has 5 bytes per event:
+// tick (signed 16 bit little endian, 0.1 ms from the /nf of this frame,
+// negative if it came in before the /nf), status, data 1, data 2
+// 32 events max, if more came in they are dropped and counted
+void sendMIDIEvents(void) {
+	midi_frame_t * f = midi_front;
+	uint32_t i;
+	uint8_t * e;
+	int16_t tick;
+
+	OSCMessage msgEvents("/mev");
+
+	for (i = 0; i < f->event_count; i++) {
+		e = &f->events[i * MIDI_EVENT_SIZE];
+		tick = (e[0] | (e[1] << 8)) - (uint16_t) frame_tick;
+		e[0] = tick & 0xFF;
+		e[1] = (tick >> 8) & 0xFF;
+	}
+
+	msgEvents.add((int32_t) f->events_dropped);
+	msgEvents.add(f->events, f->event_count * MIDI_EVENT_SIZE);
+
+	msgEvents.send(oscBuf);
+	slip.sendMessage(oscBuf.buffer, oscBuf.length);
+	msgEvents.empty();
+}
+
+// sending the controllers that changed since the last reply
+// /mcc <blob>, controller number / value byte pairs.  nothing is sent
+// if no controller moved, at most 64 go per frame and the rest follow
+// in the next ones
+void sendMIDIControllers(void) {
+	uint8_t pairs[MIDI_CC_PAIRS_MAX * 2];
+	uint8_t count;
+
+	count = midi_cc_collect(pairs, MIDI_CC_PAIRS_MAX);
+	if (!count) return;
+
+	OSCMessage msgCC("/mcc");
+
+	msgCC.add(pairs, count * 2);
+
+	msgCC.send(oscBuf);
+	slip.sendMessage(oscBuf.buffer, oscBuf.length);
+	msgCC.empty();
+}
+
+// sending the parts of the expanded state that changed since the last reply
+// /mst <blob>, 3 byte records (see midi.h), same rules as /mcc
+void sendMIDIState(void) {
+	uint8_t records[MIDI_STATE_RECORDS_MAX * 3];
+	uint8_t count;
+
+	count = midi_state_collect(records, MIDI_STATE_RECORDS_MAX);
+	if (!count) return;
+
+	OSCMessage msgState("/mst");
+
+	msgState.add(records, count * 3);
+
+	msgState.send(oscBuf);
+	slip.sendMessage(oscBuf.buffer, oscBuf.length);
+	msgState.empty();
+}
+
+// sending the tempo and where we are in the beat, right as the reply goes out
+// /clk <BPM * 100> <beat> <phase 0 - 65535> <flags>, flags are
+// MIDICLOCK_LOCKED (1) and MIDICLOCK_RUNNING (2)
+void sendMIDIClock(void) {
+	uint32_t bpm100;
+	uint32_t beat;
+	uint16_t phase;
+	uint8_t flags;
+
+	midiclock_report(timer_micros(), &bpm100, &beat, &phase, &flags);
+
+	OSCMessage msgClock("/clk");
+
+	msgClock.add((int32_t) bpm100);
+	msgClock.add((int32_t) beat);
+	msgClock.add((int32_t) phase);
+	msgClock.add((int32_t) flags);
+
+	msgClock.send(oscBuf);
+	slip.sendMessage(oscBuf.buffer, oscBuf.length);
+	msgClock.empty();
+}
+
+// SysEx
+// F0 7D 45 <cmd> ... F7 is for us (see sysex.h), set or read a setting by its
+// config key.  everything else goes to the host as
+// /sysex <flags> <dropped> <blob>, flags are SYSEX_TRUNCATED (1) and
+// SYSEX_UNTERMINATED (2), dropped is how many came in while we were busy
+void checkSysex(void) {
+	uint8_t * m;
+	uint8_t flags;
+	uint16_t dropped;
+	uint8_t len;
+	uint16_t value;
+
+	len = sysex_get(&m, &flags, &dropped);
+	if (!len) return;
+
+	if ((len >= 6) && (m[1] == SYSEX_ID_NONCOMMERCIAL) && (m[2] == SYSEX_ID_ETC) && !flags) {
+		// takes effect now, goes to flash on the host's next /save
+		if ((m[3] == SYSEX_CMD_SET) && (len == 9)) {
+			// 21 bits come in, anything past 16 would wrap into a valid looking value
+			uint32_t raw = m[5] | (m[6] << 7) | (m[7] << 14);
+			if ((raw <= 0xFFFF) && validSetting(m[4], raw)) changeSetting(m[4], raw);
+		}
+		else if ((m[3] == SYSEX_CMD_GET) && (len == 6) && config_get(m[4], &value)) {
+			uint8_t reply[9] = { 0xF0, SYSEX_ID_NONCOMMERCIAL, SYSEX_ID_ETC, SYSEX_CMD_VALUE, m[4],
+					(uint8_t) (value & 0x7F), (uint8_t) ((value >> 7) & 0x7F), (uint8_t) (value >> 14), 0xF7 };
+			midi_send_raw(reply, sizeof(reply));
+		}
+		sysex_release();
+		return;
+	}
+
+	OSCMessage msgSysex("/sysex");
+
+	msgSysex.add((int32_t) flags);
+	msgSysex.add((int32_t) dropped);
+	msgSysex.add(m, len);
+	sysex_release();
+
+	msgSysex.send(oscBuf);
+	slip.sendMessage(oscBuf.buffer, oscBuf.length);
+	msgSysex.empty();
+}
+
 // sending knob values back
 void sendKnobs(void) {
 
 	OSCMessage msgKnobs("/knobs");
 
 	uint32_t i;
-	for (i = 0; i < 6; i++) {
-		msgKnobs.add((int32_t) knobValues[i]);
+	for (i = 0; i < 5; i++) {
+		msgKnobs.add((int32_t) curve_apply(knobCurve[i], knobValues[i]));
 	}
+	msgKnobs.add((int32_t) knobValues[5]);   // foot input goes out raw
 
 	msgKnobs.send(oscBuf);
 	slip.sendMessage(oscBuf.buffer, oscBuf.length);
@@ -519,12 +1475,21 @@ void sendKnobs(void) {
 /// scan keys
 uint32_t scanKeys() {
 
+#ifdef CONFIG_OLED
+		// these lines drive the display, k1 - k5 just read as up
+		keyValuesRaw[0] = 0;
+		keyValuesRaw[1] = 0;
+		keyValuesRaw[2] = 0;
+		keyValuesRaw[3] = 0;
+		keyValuesRaw[4] = 0;
+#else
 		keyValuesRaw[0] = (GPIO_ReadInputDataBit(GPIOA, GPIO_Pin_5)) ? 0 : 100; // k1, SD
 		keyValuesRaw[1] = (GPIO_ReadInputDataBit(GPIOA, GPIO_Pin_7)) ? 0 : 100; // k2, PM
 		keyValuesRaw[2] = (GPIO_ReadInputDataBit(GPIOA, GPIO_Pin_8)) ? 0 : 100; // k3, NM
 
 		keyValuesRaw[3] = (GPIO_ReadInputDataBit(GPIOA, GPIO_Pin_9)) ? 0 : 100; // k4, OSD
 		keyValuesRaw[4] = (GPIO_ReadInputDataBit(GPIOA, GPIO_Pin_10)) ? 0 : 100; // k5, PP
+#endif
 		keyValuesRaw[5] = (GPIO_ReadInputDataBit(GPIOB, GPIO_Pin_13)) ? 0 : 100; // k6, NP
 
 		keyValuesRaw[6] = (GPIO_ReadInputDataBit(GPIOB, GPIO_Pin_14)) ? 0 : 100; // k7, SP
@@ -560,17 +1525,29 @@ void checkForKeyEvent() {
 	uint32_t i;
 
 	for (i = 0; i < 10; i++) {
+#ifdef DEBUG
+		// the clock starts on the first read that differs from the debounced state,
+		// a bounce back (or the event itself) stops it so the next edge starts fresh
+		if (keyValuesRaw[i] != keyValuesLast[i]) {
+			if (!(key_edge_pending & (1 << i))) LATENCY_STAMP(key_edge_micros[i]);
+			key_edge_pending |= (1 << i);
+		}
+		else key_edge_pending &= ~(1 << i);
+#endif
 		if ((keyValues[0][i]) && (keyValues[1][i]) && (keyValues[2][i])
 				&& (keyValues[3][i])) {
 
 			if (!keyValuesLast[i]) {
 				OSCMessage msgKey("/key");
 
+				LATENCY(LAT_KEY_EVENT, key_edge_micros[i], timer_micros());
 				msgKey.add((int32_t) i);
 				msgKey.add((int32_t) 100);
 
 				msgKey.send(oscBuf);
 				slip.sendMessage(oscBuf.buffer, oscBuf.length);
+				LATENCY(LAT_KEY_TX_START, key_edge_micros[i], slip.txMicros);
+				LATENCY(LAT_KEY_TX_DONE, key_edge_micros[i], timer_micros());
 
 				msgKey.empty(); // free space occupied by message
 				keyValuesLast[i] = 100;
@@ -581,11 +1558,14 @@ void checkForKeyEvent() {
 			if (keyValuesLast[i]) {
 				OSCMessage msgKey("/key");
 
+				LATENCY(LAT_KEY_EVENT, key_edge_micros[i], timer_micros());
 				msgKey.add((int32_t) i);
 				msgKey.add((int32_t) 0);
 
 				msgKey.send(oscBuf);
 				slip.sendMessage(oscBuf.buffer, oscBuf.length);
+				LATENCY(LAT_KEY_TX_START, key_edge_micros[i], slip.txMicros);
+				LATENCY(LAT_KEY_TX_DONE, key_edge_micros[i], timer_micros());
 
 				msgKey.empty();
 				keyValuesLast[i] = 0;
@@ -598,7 +1578,7 @@ void checkForKeyEvent() {
 
 void updateKnobs() {
 
-	// see if a new conversion is ready
+	// see if a new conversion is ready,  this happens once per TIM3 trigger
 	if ((DMA_GetFlagStatus(DMA1_FLAG_TC1)) == SET) {
 		DMA_ClearFlag(DMA1_FLAG_TC1);
 
@@ -608,41 +1588,144 @@ void updateKnobs() {
 		knobValues[3] = RegularConvData_Tab[3];
 		knobValues[2] = RegularConvData_Tab[4];
 		knobValues[5] = RegularConvData_Tab[5];
+
+		// smooth the foot input for the expression pedal,
+		// one pole with a ~8 ms time constant at ADC_SAMPLE_RATE_HZ
+		if (foot_filtered < 0) foot_filtered = knobValues[5] << 4;
+		else foot_filtered += ((int32_t) (knobValues[5] << 4) - foot_filtered) >> 3;
+	}
+}
+
+// send the knobs that moved since they were last sent,
+// no more than knob_report_rate times a second
+void checkKnobMotion(void) {
+	static uint32_t lastReport = 0;
+	uint32_t now;
+	uint32_t i;
+	uint32_t moved = 0;
+
+	if (!knob_report_rate) return;
+
+	now = timer_ticks;
+	if ((now - lastReport) < (TIMER_FREQUENCY_HZ / knob_report_rate)) return;
+
+	// the foot switch (5) is not a knob, it goes out on its own
+	for (i = 0; i < 5; i++) {
+		if ((knobValues[i] + KNOB_DEADBAND <= knobValuesSent[i]) ||
+				(knobValues[i] >= knobValuesSent[i] + KNOB_DEADBAND)) {
+			moved |= (1 << i);
+		}
 	}
+	if (!moved) return;
+
+	lastReport = now;
+
+	OSCMessage msgKnobs("/kt");
+
+	msgKnobs.add((int32_t) timer_micros());
+	for (i = 0; i < 5; i++) {
+		if (moved & (1 << i)) {
+			msgKnobs.add((int32_t) i);
+			msgKnobs.add((int32_t) curve_apply(knobCurve[i], knobValues[i]));
+			knobValuesSent[i] = knobValues[i];
+		}
+	}
+
+	msgKnobs.send(oscBuf);
+	slip.sendMessage(oscBuf.buffer, oscBuf.length);
+	msgKnobs.empty();
 }
 
 // check for foot switch change
 void checkFootSwitch (void) {
 	static uint8_t foot_last = 0;
-	static uint8_t foot_debounce[2] = {0, 0};
-	static uint8_t foot_debounce_count = 0;
-
-	if (knobValues[5] < 100) foot_debounce[foot_debounce_count] = 0;
-	if (knobValues[5] > 900) foot_debounce[foot_debounce_count] = 1;
-
-	foot_debounce_count++;
-	foot_debounce_count &= 1;
-	//only proceed if debounced (same for 2 times)
-	if (foot_debounce[0] == foot_debounce[1]){
-		if ((knobValues[5] < 100) && foot_last){
-			foot_last = 0;
-			// send press
-			OSCMessage msgEncoder("/fs");
-			msgEncoder.add(1);
-			msgEncoder.send(oscBuf);
-			slip.sendMessage(oscBuf.buffer, oscBuf.length);
-			foot_down = 1;
+	static uint8_t foot_reading = 0;
+	static uint32_t foot_reading_since = 0;
+	uint8_t reading;
+	uint32_t now = timer_ticks;
+
+	if (foot_expression) {
+		checkExpressionPedal();
+		return;
+	}
+
+	// a pedal sits mid range, a switch only passes through
+	if ((foot_mode == FOOT_MODE_AUTO) && (foot_filtered >= 0)) {
+		if (((foot_filtered >> 4) > FOOT_SWITCH_LOW) && ((foot_filtered >> 4) < FOOT_SWITCH_HIGH)) {
+			if ((now - foot_mid_since) > FOOT_DETECT_TICKS) {
+				foot_expression = 1;
+				foot_down = 0;
+				return;
+			}
 		}
-		if ((knobValues[5] > 900) && !foot_last){
-			foot_last = 1;
-			// send press
-			OSCMessage msgEncoder("/fs");
-			msgEncoder.add(0);
-			msgEncoder.send(oscBuf);
-			slip.sendMessage(oscBuf.buffer, oscBuf.length);
-			foot_down = 0;
+		else {
+			foot_mid_since = now;
 		}
 	}
+
+	if (knobValues[5] < FOOT_SWITCH_LOW) reading = 1;        // down
+	else if (knobValues[5] > FOOT_SWITCH_HIGH) reading = 2;  // up
+	else return;   // in between, wait for it to settle
+
+	//only proceed if debounced (same for FOOT_DEBOUNCE_TICKS)
+	if (reading != foot_reading) {
+		foot_reading = reading;
+		foot_reading_since = now;
+		return;
+	}
+	if ((now - foot_reading_since) < FOOT_DEBOUNCE_TICKS) return;
+
+	if ((reading == 1) && foot_last){
+		foot_last = 0;
+		// send press
+		OSCMessage msgEncoder("/fs");
+		msgEncoder.add(1);
+		msgEncoder.send(oscBuf);
+		slip.sendMessage(oscBuf.buffer, oscBuf.length);
+		foot_down = 1;
+	}
+	if ((reading == 2) && !foot_last){
+		foot_last = 1;
+		// send press
+		OSCMessage msgEncoder("/fs");
+		msgEncoder.add(0);
+		msgEncoder.send(oscBuf);
+		slip.sendMessage(oscBuf.buffer, oscBuf.length);
+		foot_down = 0;
+	}
+}
+
+// expression pedal, the range is learned as the pedal is swept
+// and the value (0 - 1023) only goes out when it changes
+void checkExpressionPedal(void) {
+	uint32_t v;
+	uint32_t out;
+
+	if (foot_filtered < 0) return;
+
+	v = foot_filtered >> 4;
+	if (v < foot_cal_min) foot_cal_min = v;
+	if (v > foot_cal_max) foot_cal_max = v;
+	if ((foot_cal_max - foot_cal_min) < FOOT_CAL_MIN_SPAN) return;
+
+	out = ((v - foot_cal_min) * 1023) / (foot_cal_max - foot_cal_min);
+
+	if ((out + FOOT_EXP_DEADBAND <= foot_exp_sent) || (out >= foot_exp_sent + FOOT_EXP_DEADBAND) ||
+			(((out == 0) || (out == 1023)) && (out != foot_exp_sent))) {
+		foot_exp_sent = out;
+		OSCMessage msgExp("/exp");
+		msgExp.add((int32_t) out);
+		msgExp.send(oscBuf);
+		slip.sendMessage(oscBuf.buffer, oscBuf.length);
+		msgExp.empty();
+	}
+}
+
+void resetFootCalibration(void) {
+	foot_cal_min = 1023;
+	foot_cal_max = 0;
+	foot_mid_since = timer_ticks;
+	foot_exp_sent = 0xFFFF;
 }
 
 #pragma GCC diagnostic pop
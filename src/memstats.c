@@ -0,0 +1,46 @@
+/*
+ * memstats.c
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#include "memstats.h"
+#include "cmsis_device.h"
+
+#define MEMSTATS_PAINT 0xA5A5A5A5
+#define MEMSTATS_MARGIN 32   // bytes left alone under the stack pointer while painting
+
+// linker script (sections.ld)
+extern char _Heap_Begin;
+extern char _Heap_Limit;
+extern char __stack;
+extern char _Main_Stack_Size;
+
+// _sbrk.c
+extern char * _sbrk_peak(void);
+extern unsigned int _sbrk_failures(void);
+
+void memstats_paint(void) {
+	uint32_t * p = (uint32_t *) (((uint32_t) _sbrk_peak() + 3) & ~3);
+	uint32_t * sp = (uint32_t *) (__get_MSP() - MEMSTATS_MARGIN);
+
+	while (p < sp)
+		*p++ = MEMSTATS_PAINT;
+}
+
+void memstats_get(memstats_t * stats) {
+	char * heap_end = _sbrk_peak();
+	uint32_t * p = (uint32_t *) (((uint32_t) heap_end + 3) & ~3);
+	uint32_t * top = (uint32_t *) &__stack;
+
+	// the heap never got above its peak, so the first word that isn't paint is the stack
+	while ((p < top) && (*p == MEMSTATS_PAINT))
+		p++;
+
+	stats->stack_peak = (uint32_t) &__stack - (uint32_t) p;
+	stats->stack_size = (uint32_t) &_Main_Stack_Size;
+	stats->heap_peak = heap_end - &_Heap_Begin;
+	stats->heap_size = &_Heap_Limit - &_Heap_Begin;
+	stats->untouched = (uint32_t) p - (uint32_t) heap_end;
+	stats->heap_failures = _sbrk_failures();
+}
@@ -0,0 +1,32 @@
+/*
+ * memstats.h
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#ifndef MEMSTATS_H_
+#define MEMSTATS_H_
+
+#include <stdint.h>
+
+// how close to the edge RAM runs.
+// the free RAM between the heap and the stack is painted at boot, the
+// deepest the stack (interrupts included, they share it) has been is where the paint stops.
+// the heap peak is the highest _sbrk break.
+
+typedef struct {
+	uint32_t stack_peak;     // bytes below the top of RAM the stack has reached
+	uint32_t stack_size;     // what the linker script reserves (_Main_Stack_Size)
+	uint32_t heap_peak;      // bytes of heap ever handed out by _sbrk
+	uint32_t heap_size;      // room the linker script leaves for it
+	uint32_t untouched;      // never written, between the heap peak and the stack peak
+	uint32_t heap_failures;  // _sbrk requests that didn't fit
+} memstats_t;
+
+// first thing in main, before anything goes on the heap
+void memstats_paint(void);
+
+// walks the painted area, so call it when asked not every loop
+void memstats_get(memstats_t * stats);
+
+#endif /* MEMSTATS_H_ */
@@ -7,9 +7,17 @@
 
 #include "midi.h"
 #include "uart.h"
+#include "Timer.h"
+#include "midiclock.h"
+#include "sysex.h"
 
 
-uint8_t midi_blob[23];  // 16 bytes for note states, 5 bytes CC, 1 byte sync number, 1 byte program
+// parsing happens in the USART1 ISR, it fills in the back frame while the
+// main loop sends the front one, midi_frame_swap() trades them
+static midi_frame_t midi_frames[2];
+static midi_frame_t * volatile midi_back = &midi_frames[0];
+midi_frame_t * midi_front = &midi_frames[1];
+
 uint8_t new_midi_flag = 0;
 
 // indexes for midi_blob (first 16 bytes are binary note states in 128 bit field)
@@ -21,168 +29,479 @@ uint8_t new_midi_flag = 0;
 #define SYNC 21
 #define PGM 22
 
-void recvByte(int byte) {
-        int tmp;
-    int channel;
-    int bigval;           /*  temp 14-bit value for pitch, song pos */
+uint8_t midi_mode = MIDI_MODE_SNAPSHOT;
 
+// bit n is channel n + 1
+uint16_t midi_channel_mask = 0xFFFF;
 
-    if ((recvMode_ & MODE_PROPRIETARY)
-      && byte != STATUS_END_PROPRIETARY)
-    {
-        /* If proprietary handling compiled in, just pass all data received
-         *  after a START_PROPRIETARY event to proprietary_decode
-         *  until get an END_PROPRIETARY event
-         */
+midi_frame_t * midi_frame_swap(void) {
+	midi_frame_t * front = midi_back;
+	uint8_t i;
 
-#ifdef CONFIG_MIDI_PROPRIETARY
-        proprietaryDecode(byte);
-#endif
+	__disable_irq();
+	midi_back = midi_front;
+	midi_front = front;
 
-        return;
-    }
+	// the snapshot carries on, the event list starts over
+	for (i = 0; i < 23; i++) midi_back->blob[i] = front->blob[i];
+	midi_back->event_count = 0;
+	midi_back->events_dropped = 0;
+	__enable_irq();
 
-    if (byte & 0x80) {
+	return front;
+}
 
-        /* All < 0xf0 events get at least 1 arg byte so
-         *  it's ok to mask off the low 4 bits to figure
-         *  out how to handle the event for < 0xf0 events.
-         */
-
-        tmp = byte;
-
-        if (tmp < 0xf0)
-            tmp &= 0xf0;
-
-        switch (tmp) {
-            /* These status events take 2 bytes as arguments */
-            case STATUS_EVENT_NOTE_OFF:
-            case STATUS_EVENT_NOTE_ON:
-            case STATUS_EVENT_VELOCITY_CHANGE:
-            case STATUS_EVENT_CONTROL_CHANGE:
-            case STATUS_PITCH_CHANGE:
-            case STATUS_SONG_POSITION:
-                recvBytesNeeded_ = 2;
-                recvByteCount_ = 0;
-                recvEvent_ = byte;
-                break;
+void midi_events_clear(void) {
+	__disable_irq();
+	midi_back->event_count = 0;
+	midi_back->events_dropped = 0;
+	__enable_irq();
+}
 
-            /* 1 byte arguments */
-            case STATUS_EVENT_PROGRAM_CHANGE:
-            case STATUS_AFTER_TOUCH:
-            case STATUS_SONG_SELECT:
-                recvBytesNeeded_ = 1;
-                recvByteCount_ = 0;
-                recvEvent_ = byte;
-                return;
+// every controller, and a bit for each one that changed since it was last sent
+uint8_t midi_cc[128];
+uint32_t midi_cc_dirty[4];
+
+// lowest set bit of a 128 bit dirty mask, cleared on the way out
+// returns 0xFF if there is none.  the ISR sets bits, so clearing one is
+// done with it held off
+static uint8_t next_dirty(uint32_t * dirty) {
+	uint8_t i, n;
+
+	for (i = 0; i < 4; i++) {
+		if (dirty[i]) {
+			n = __builtin_ctz(dirty[i]);
+			__disable_irq();
+			dirty[i] &= ~(1UL << n);
+			__enable_irq();
+			return (i << 5) + n;
+		}
+	}
+	return 0xFF;
+}
 
-            /* No arguments ( > 0xf0 events) */
-            case STATUS_START_PROPRIETARY:
-                recvMode_ |= MODE_PROPRIETARY;
+static void mark_dirty(uint32_t * dirty, uint8_t n) {
+	dirty[(n >> 5) & 3] |= (1UL << (n & 0x1f));
+}
 
-#ifdef CONFIG_MIDI_PROPRIETARY
-                proprietaryDecodeStart();
-#endif
+uint8_t midi_cc_collect(uint8_t * buf, uint8_t max) {
+	uint8_t cc;
+	uint8_t count = 0;
 
-                break;
-            case STATUS_END_PROPRIETARY:
-                recvMode_ &= ~MODE_PROPRIETARY;
+	while ((count < max) && ((cc = next_dirty(midi_cc_dirty)) != 0xFF)) {
+		buf[count * 2] = cc;
+		buf[(count * 2) + 1] = midi_cc[cc];
+		count++;
+	}
+	return count;
+}
 
-#ifdef CONFIG_MIDI_PROPRIETARY
-                proprietaryDecodeEnd();
-#endif
+void midi_cc_mark_all(void) {
+	midi_cc_dirty[0] = midi_cc_dirty[1] = midi_cc_dirty[2] = midi_cc_dirty[3] = 0xFFFFFFFF;
+}
 
+// expanded state, velocity of every note (0 when off), poly and channel
+// pressure, pitch bend and the mod wheel (CC 1 / 33), both 14 bit
+uint8_t midi_velocity[128];
+uint8_t midi_poly_pressure[128];
+uint8_t midi_channel_pressure;
+uint16_t midi_pitch_bend;
+uint16_t midi_mod_wheel;
+
+uint32_t midi_velocity_dirty[4];
+uint32_t midi_poly_pressure_dirty[4];
+uint8_t midi_state_dirty;   // MIDI_STATE_* bits for the single values
+
+#define MIDI_STATE_CHANNEL_PRESSURE 1
+#define MIDI_STATE_PITCH_BEND 2
+#define MIDI_STATE_MOD_WHEEL 4
+
+static uint8_t * state_record(uint8_t * buf, uint8_t tag, uint8_t data1, uint8_t data2) {
+	buf[0] = tag;
+	buf[1] = data1;
+	buf[2] = data2;
+	return buf + 3;
+}
+
+uint8_t midi_state_collect(uint8_t * buf, uint8_t max) {
+	uint8_t n;
+	uint8_t count = 0;
+	uint8_t dirty;
+
+	__disable_irq();
+	dirty = midi_state_dirty;
+	midi_state_dirty = 0;
+	__enable_irq();
+
+	// the single values first, they are what usually moves
+	if ((count < max) && (dirty & MIDI_STATE_PITCH_BEND)) {
+		buf = state_record(buf, STATUS_PITCH_CHANGE, midi_pitch_bend & 0x7f, midi_pitch_bend >> 7);
+		dirty &= ~MIDI_STATE_PITCH_BEND;
+		count++;
+	}
+	if ((count < max) && (dirty & MIDI_STATE_MOD_WHEEL)) {
+		buf = state_record(buf, STATUS_EVENT_CONTROL_CHANGE, midi_mod_wheel & 0x7f, midi_mod_wheel >> 7);
+		dirty &= ~MIDI_STATE_MOD_WHEEL;
+		count++;
+	}
+	if ((count < max) && (dirty & MIDI_STATE_CHANNEL_PRESSURE)) {
+		buf = state_record(buf, STATUS_AFTER_TOUCH, midi_channel_pressure, 0);
+		dirty &= ~MIDI_STATE_CHANNEL_PRESSURE;
+		count++;
+	}
+
+	// whatever didn't fit goes next time
+	if (dirty) {
+		__disable_irq();
+		midi_state_dirty |= dirty;
+		__enable_irq();
+	}
+
+	while ((count < max) && ((n = next_dirty(midi_velocity_dirty)) != 0xFF)) {
+		buf = state_record(buf, STATUS_EVENT_NOTE_ON, n, midi_velocity[n]);
+		count++;
+	}
+	while ((count < max) && ((n = next_dirty(midi_poly_pressure_dirty)) != 0xFF)) {
+		buf = state_record(buf, STATUS_EVENT_VELOCITY_CHANGE, n, midi_poly_pressure[n]);
+		count++;
+	}
+	return count;
+}
+
+void midi_state_mark_all(void) {
+	uint8_t i;
+
+	for (i = 0; i < 4; i++) {
+		midi_velocity_dirty[i] = 0xFFFFFFFF;
+		midi_poly_pressure_dirty[i] = 0xFFFFFFFF;
+	}
+	midi_state_dirty = MIDI_STATE_CHANNEL_PRESSURE | MIDI_STATE_PITCH_BEND | MIDI_STATE_MOD_WHEEL;
+}
+
+void midi_event_push(uint8_t status, uint8_t data1, uint8_t data2) {
+	midi_frame_t * f = midi_back;
+	uint8_t * e;
+	uint16_t tick;
+
+	if (!(midi_mode & MIDI_MODE_EVENTS)) return;
+
+	if (f->event_count == MIDI_EVENT_MAX) {
+		if (f->events_dropped < 0xFFFF) f->events_dropped++;
+		return;
+	}
+
+	tick = timer_ticks;
+	e = &f->events[f->event_count * MIDI_EVENT_SIZE];
+	e[0] = tick & 0xFF;
+	e[1] = tick >> 8;
+	e[2] = status;
+	e[3] = data1;
+	e[4] = data2;
+	f->event_count++;
+}
+
+/* What follows each status byte, indexed by the byte itself:
+ *  the low bits are the number of data bytes, STATUS_VOICE marks channel
+ *  messages (filtered by channel, running status applies), STATUS_REALTIME
+ *  marks bytes that can show up anywhere, even in the middle of another
+ *  message, and don't change the parser state.  Data bytes are 0.
+ */
+#define STATUS_VOICE 0x40
+#define STATUS_REALTIME 0x80
+#define V1 (STATUS_VOICE | 1)
+#define V2 (STATUS_VOICE | 2)
+#define RT STATUS_REALTIME
+#define ROW(x) x, x, x, x, x, x, x, x, x, x, x, x, x, x, x, x
+
+static const uint8_t status_info[256] = {
+    ROW(0), ROW(0), ROW(0), ROW(0), ROW(0), ROW(0), ROW(0), ROW(0),  /* data */
+    ROW(V2),    /* 0x80 note off */
+    ROW(V2),    /* 0x90 note on */
+    ROW(V2),    /* 0xA0 poly pressure */
+    ROW(V2),    /* 0xB0 control change */
+    ROW(V1),    /* 0xC0 program change */
+    ROW(V1),    /* 0xD0 channel pressure */
+    ROW(V2),    /* 0xE0 pitch bend */
+    /* 0xF0 sysex, MTC quarter frame, song position, song select, undefined x2,
+     *  tune request, end of sysex, then the realtime ones
+     */
+    0, 1, 2, 1, 0, 0, 0, 0, RT, RT, RT, RT, RT, RT, RT, RT
+};
+
+static void thru(uint8_t status, uint8_t data1, uint8_t data2);
+
+/* pass a complete message on, if it is on a channel we are listening to */
+static void dispatch(uint8_t status, uint8_t data1, uint8_t data2) {
+    unsigned int channel = (status & 0x0f) + 1;
+    uint8_t type = status;
+
+    if (status < 0xf0) {
+        type &= 0xf0;
+        if (!(midi_channel_mask & (1 << (channel - 1))))
+            return;
+    }
+
+    /* note on with velocity 0 goes in the event list as a note off,
+     *  MTC is too busy to be worth listing
+     */
+    if ((type == STATUS_EVENT_NOTE_ON) && !data2)
+        midi_event_push(STATUS_EVENT_NOTE_OFF | (status & 0x0f), data1, 0);
+    else if (type != STATUS_MTC_QUARTER_FRAME)
+        midi_event_push(status, data1, data2);
+
+    switch (type) {
+        case STATUS_EVENT_NOTE_ON:
+            /* If velocity is 0, it's actually a note off & should fall thru
+             *  to the note off case
+             */
+            if (data2) {
+                handleNoteOn(channel, data1, data2);
                 break;
-            case STATUS_TUNE_REQUEST:
-                handleTuneRequest();
-                break;
-            case STATUS_SYNC:
-                handleSync();
-                break;
-            case STATUS_START:
-                handleStart();
-                break;
-            case STATUS_CONTINUE:
-                handleContinue();
-                break;
-            case STATUS_STOP:
-                handleStop();
-                break;
-            case STATUS_ACTIVE_SENSE:
-                handleActiveSense();
-                break;
-            case STATUS_RESET:
-                handleReset();
-                break;
-        }
+            }
 
-        return;
+        case STATUS_EVENT_NOTE_OFF:
+            handleNoteOff(channel, data1, data2);
+            break;
+        case STATUS_EVENT_VELOCITY_CHANGE:
+            handleVelocityChange(channel, data1, data2);
+            break;
+        case STATUS_EVENT_CONTROL_CHANGE:
+            handleControlChange(channel, data1, data2);
+            break;
+        case STATUS_EVENT_PROGRAM_CHANGE:
+            handleProgramChange(channel, data1);
+            break;
+        case STATUS_AFTER_TOUCH:
+            handleAfterTouch(channel, data1);
+            break;
+        case STATUS_PITCH_CHANGE:
+            handlePitchChange((data2 << 7) | data1);
+            break;
+        case STATUS_SONG_POSITION:
+            handleSongPosition((data2 << 7) | data1);
+            break;
+        case STATUS_SONG_SELECT:
+            handleSongSelect(data1);
+            break;
+        case STATUS_TUNE_REQUEST:
+            handleTuneRequest();
+            break;
     }
+}
 
-    if (++recvByteCount_ == recvBytesNeeded_) {
-        /* Copy out the channel (if applicable; in some cases this will be meaningless,
-         *  but in those cases the value will be ignored)
-         */
-        channel = (recvEvent_ & 0x0f) + 1;
+static void realtime(uint8_t byte) {
+    switch (byte) {
+        case STATUS_SYNC:
+            handleSync();
+            break;
+        case STATUS_START:
+            midi_event_push(byte, 0, 0);
+            handleStart();
+            break;
+        case STATUS_CONTINUE:
+            midi_event_push(byte, 0, 0);
+            handleContinue();
+            break;
+        case STATUS_STOP:
+            midi_event_push(byte, 0, 0);
+            handleStop();
+            break;
+        case STATUS_ACTIVE_SENSE:
+            handleActiveSense();
+            break;
+        case STATUS_RESET:
+            midi_event_push(byte, 0, 0);
+            handleReset();
+            break;
+    }
+}
+
+// runs in the USART1 ISR.  it stays in flash: from RAM every call out to thru,
+// dispatch, realtime and sysex_* goes through a veneer, which costs more than
+// the wait states save on anything but a lone data byte
+void recvByte(int byte) {
+    uint8_t info;
+
+    byte &= 0xff;
+    info = status_info[byte];
+
+    /* realtime can come in anywhere, it doesn't touch the state */
+    if (info & STATUS_REALTIME) {
+        thru(byte, 0, 0);
+        realtime(byte);
+        return;
+    }
 
-        tmp = recvEvent_;
-        if (tmp < 0xf0) {
-            tmp &= 0xf0;
+    if (byte & 0x80) {
+        /* any status byte ends a sysex, not just STATUS_END_PROPRIETARY */
+        if (recvMode_ & MODE_PROPRIETARY) {
+            recvMode_ &= ~MODE_PROPRIETARY;
+            if (midi_thru & MIDI_THRU_SYSEX)
+                put_char(STATUS_END_PROPRIETARY);
+            sysex_end(byte == STATUS_END_PROPRIETARY);
         }
 
-        /* See if this event matches our MIDI channel
-         *  (or we're accepting for all channels)
-         */
-        if (!channelIn_
-             || (channel == channelIn_)
-             || (tmp >= 0xf0))
-        {
-            switch (tmp) {
-                case STATUS_EVENT_NOTE_ON:
-                    /* If velocity is 0, it's actually a note off & should fall thru
-                     *  to the note off case
-                     */
-                    if (byte) {
-                        handleNoteOn(channel, recvArg0_, byte);
-                        break;
-                    }
-
-                case STATUS_EVENT_NOTE_OFF:
-                    handleNoteOff(channel, recvArg0_, byte);
-                    break;
-                case STATUS_EVENT_VELOCITY_CHANGE:
-                    handleVelocityChange(channel, recvArg0_, byte);
-                    break;
-                case STATUS_EVENT_CONTROL_CHANGE:
-                    handleControlChange(channel, recvArg0_, byte);
-                    break;
-                case STATUS_EVENT_PROGRAM_CHANGE:
-                    handleProgramChange(channel, byte);
-                    break;
-                case STATUS_AFTER_TOUCH:
-                    handleAfterTouch(channel, byte);
-                    break;
-                case STATUS_PITCH_CHANGE:
-                    bigval = (byte << 7) | recvArg0_;
-                    handlePitchChange(bigval);
-                    break;
-                case STATUS_SONG_POSITION:
-                    bigval = (byte << 7) | recvArg0_;
-                    handleSongPosition(bigval);
-                    break;
-                case STATUS_SONG_SELECT:
-                    handleSongSelect(byte);
-                    break;
+        recvEvent_ = 0;
+        recvByteCount_ = 0;
+
+        if (byte == STATUS_START_PROPRIETARY) {
+            recvMode_ |= MODE_PROPRIETARY;
+            if (midi_thru & MIDI_THRU_SYSEX) {
+                lastStatusSent_ = 0;
+                put_char(byte);
             }
+            sysex_start();
+            return;
         }
+        if (byte == STATUS_END_PROPRIETARY)
+            return;
+
+        recvBytesNeeded_ = info & 0x0f;
+        if (recvBytesNeeded_)
+            recvEvent_ = byte;
+        else if (byte == STATUS_TUNE_REQUEST) {
+            thru(byte, 0, 0);
+            dispatch(byte, 0, 0);
+        }
+        return;
+    }
 
-        /* Just reset the byte count; keep the same event -- might get more messages
-            trailing from current event.
-         */
-        recvByteCount_ = 0;
+    if (recvMode_ & MODE_PROPRIETARY) {
+        if (midi_thru & MIDI_THRU_SYSEX)
+            put_char(byte);
+        sysex_byte(byte);
+        return;
+    }
+
+    /* data without a status to go with it */
+    if (!recvEvent_)
+        return;
+
+    if (++recvByteCount_ < recvBytesNeeded_) {
+        recvArg0_ = byte;
+        return;
+    }
+    recvByteCount_ = 0;
+
+    if (recvBytesNeeded_ == 1) {
+        thru(recvEvent_, byte, 0);
+        dispatch(recvEvent_, byte, 0);
+    }
+    else {
+        thru(recvEvent_, recvArg0_, byte);
+        dispatch(recvEvent_, recvArg0_, byte);
+    }
+
+    /* running status only goes for channel messages, keep the same event
+     *  for those -- might get more messages trailing from it
+     */
+    if (!(status_info[recvEvent_] & STATUS_VOICE))
+        recvEvent_ = 0;
+}
+
+
+/* MIDI out.  Messages go in the DMA queue whole, so the thru (from the
+ *  USART1 ISR) and the main loop can't cut into each other's messages;
+ *  the main loop holds the ISR off while it queues.  If there is no room
+ *  the whole message is dropped.
+ */
+uint8_t midi_thru = 0;
+
+static void out_lock(void) {
+    if (!__get_IPSR())
+        NVIC_DisableIRQ(USART1_IRQn);
+}
+
+static void out_unlock(void) {
+    if (!__get_IPSR())
+        NVIC_EnableIRQ(USART1_IRQn);
+}
+
+/* a single byte as is (realtime) */
+void put_char(uint8_t c)
+{
+    out_lock();
+    uart1_queue(&c, 1);
+    out_unlock();
+}
+
+/* a complete message, running status is used for channel messages
+ *  unless sendFullCommands_ is set
+ */
+void midi_send(uint8_t status, uint8_t data1, uint8_t data2)
+{
+    uint8_t info = status_info[status];
+    uint8_t msg[3];
+    uint8_t len = 0;
+
+    out_lock();
+    if ((info & STATUS_REALTIME) || !(info & STATUS_VOICE)
+            || sendFullCommands_ || (lastStatusSent_ != status)) {
+        msg[len++] = status;
     }
+    if ((info & 0x0f) > 0) msg[len++] = data1;
+    if ((info & 0x0f) > 1) msg[len++] = data2;
+
+    if (uart1_queue(msg, len)) {
+        /* realtime doesn't touch running status, system common ends it */
+        if (info & STATUS_VOICE)
+            lastStatusSent_ = status;
+        else if (!(info & STATUS_REALTIME))
+            lastStatusSent_ = 0;
+    }
+    out_unlock();
+}
 
-    recvArg0_ = byte;
+/* bytes from the host, split up at status bytes so each message goes
+ *  in whole.  what was sent last is unknown after this, so the next
+ *  message gets a full status
+ */
+void midi_send_raw(const uint8_t * bytes, uint16_t len)
+{
+    uint16_t start = 0;
+    uint16_t end;
+
+    while (start < len) {
+        end = start + 1;
+        if (!(status_info[bytes[start]] & STATUS_REALTIME)) {
+            while ((end < len) && !(bytes[end] & 0x80))
+                end++;
+            /* a sysex goes with its end byte */
+            if ((bytes[start] == STATUS_START_PROPRIETARY) && (end < len)
+                    && (bytes[end] == STATUS_END_PROPRIETARY))
+                end++;
+        }
+
+        out_lock();
+        uart1_queue(&bytes[start], end - start);
+        if (!(status_info[bytes[start]] & STATUS_REALTIME))
+            lastStatusSent_ = 0;
+        out_unlock();
+
+        start = end;
+    }
+}
+
+/* soft thru, called from the parser with each complete message */
+static void thru(uint8_t status, uint8_t data1, uint8_t data2)
+{
+    uint8_t info = status_info[status];
+
+    if (info & STATUS_VOICE) {
+        if (!(midi_thru & MIDI_THRU_VOICE))
+            return;
+        if (!(midi_thru & MIDI_THRU_ALL_CHANNELS)
+                && !(midi_channel_mask & (1 << (status & 0x0f))))
+            return;
+    }
+    else if (info & STATUS_REALTIME) {
+        if (!(midi_thru & MIDI_THRU_REALTIME))
+            return;
+    }
+    else if (!(midi_thru & MIDI_THRU_COMMON)) {
+        return;
+    }
+    midi_send(status, data1, data2);
 }
 
 
@@ -193,13 +512,7 @@ void sendNoteOff(unsigned int channel, unsigned int note, unsigned int velocity)
 	channel = channelIn_;   // use the input channel
     int status = STATUS_EVENT_NOTE_OFF | ((channel - 1) & 0x0f);
 
-
-    if (sendFullCommands_ || (lastStatusSent_ != status)) {
-        put_char(status);
-    }
-
-    put_char(note & 0x7f);
-    put_char(velocity & 0x7f);
+    midi_send(status, note & 0x7f, velocity & 0x7f);
 }
 
 
@@ -209,12 +522,7 @@ void sendNoteOn(unsigned int channel, unsigned int note, unsigned int velocity)
 	channel = channelIn_;  // use the input channel
     int status = STATUS_EVENT_NOTE_ON | ((channel - 1) & 0x0f);
 
-    if (sendFullCommands_ || (lastStatusSent_ != status)) {
-        put_char(status);
-    }
-
-    put_char(note & 0x7f);
-    put_char(velocity & 0x7f);
+    midi_send(status, note & 0x7f, velocity & 0x7f);
 }
 
 
@@ -224,13 +532,7 @@ void sendVelocityChange(unsigned int channel, unsigned int note, unsigned int ve
 {
     int status = STATUS_EVENT_VELOCITY_CHANGE | ((channel - 1) & 0x0f);
 
-
-    if (sendFullCommands_ || (lastStatusSent_ != status)) {
-        put_char(status);
-    }
-
-    put_char(note & 0x7f);
-    put_char(velocity & 0x7f);
+    midi_send(status, note & 0x7f, velocity & 0x7f);
 }
 
 
@@ -240,13 +542,7 @@ void sendControlChange(unsigned int channel, unsigned int controller, unsigned i
 {
     int status = STATUS_EVENT_CONTROL_CHANGE | ((channel - 1) & 0x0f);
 
-
-    if (sendFullCommands_ || (lastStatusSent_ != status)) {
-        put_char(status);
-    }
-
-    put_char(controller & 0x7f);
-    put_char(value & 0x7f);
+    midi_send(status, controller & 0x7f, value & 0x7f);
 }
 
 
@@ -255,12 +551,7 @@ void sendProgramChange(unsigned int channel, unsigned int program)
 {
     int status = STATUS_EVENT_PROGRAM_CHANGE | ((channel - 1) & 0x0f);
 
-
-    if (sendFullCommands_ || (lastStatusSent_ != status)) {
-        put_char(status);
-    }
-
-    put_char(program & 0x7f);
+    midi_send(status, program & 0x7f, 0);
 }
 
 
@@ -269,45 +560,35 @@ void sendAfterTouch(unsigned int channel, unsigned int velocity)
 {
     int status = STATUS_AFTER_TOUCH | ((channel - 1) & 0x0f);
 
-
-    if (sendFullCommands_ || (lastStatusSent_ != status)) {
-        put_char(status);
-    }
-
-    put_char(velocity & 0x7f);
+    midi_send(status, velocity & 0x7f, 0);
 }
 
 
 // Send a Midi PITCH CHANGE message, with a 14-bit pitch (always for all channels)
 void sendPitchChange(unsigned int pitch)
 {
-    put_char(STATUS_PITCH_CHANGE);
-    put_char(pitch & 0x7f);
-    put_char((pitch >> 7) & 0x7f);
+    midi_send(STATUS_PITCH_CHANGE, pitch & 0x7f, (pitch >> 7) & 0x7f);
 }
 
 
 // Send a Midi SONG POSITION message, with a 14-bit position (always for all channels)
 void sendSongPosition(unsigned int position)
 {
-    put_char(STATUS_SONG_POSITION);
-    put_char(position & 0x7f);
-    put_char((position >> 7) & 0x7f);
+    midi_send(STATUS_SONG_POSITION, position & 0x7f, (position >> 7) & 0x7f);
 }
 
 
 // Send a Midi SONG SELECT message, with a song ID of 0-127 (always for all channels)
 void sendSongSelect(unsigned int song)
 {
-    put_char(STATUS_SONG_SELECT);
-    put_char(song & 0x7f);
+    midi_send(STATUS_SONG_SELECT, song & 0x7f, 0);
 }
 
 
 // Send a Midi TUNE REQUEST message (TUNE REQUEST is always for all channels)
 void sendTuneRequest(void)
 {
-    put_char(STATUS_TUNE_REQUEST);
+    midi_send(STATUS_TUNE_REQUEST, 0, 0);
 }
 
 
@@ -355,6 +636,9 @@ void sendReset(void)
 
 void midi_init(uint8_t ch)
 {
+    // the ISR parses straight into this
+    __disable_irq();
+
     /* Not in proprietary stream */
     recvMode_ = 0;
     /* No bytes recevied */
@@ -371,7 +655,7 @@ void midi_init(uint8_t ch)
     sendFullCommands_ = 0;
 
     /* Listening to all channels (set to 0)*/
-    channelIn_ = ch;
+    midi_set_channel(ch);
 
     //
     new_midi_flag = 0;
@@ -379,8 +663,37 @@ void midi_init(uint8_t ch)
     // zero out the blob
     int i;
     for (i = 0; i < 23; i++){
-    	midi_blob[i] = 0;
+    	midi_frames[0].blob[i] = 0;
+    	midi_frames[1].blob[i] = 0;
+    }
+
+    // and the event lists
+    midi_frames[0].event_count = midi_frames[1].event_count = 0;
+    midi_frames[0].events_dropped = midi_frames[1].events_dropped = 0;
+
+    // and the controllers
+    for (i = 0; i < 128; i++){
+    	midi_cc[i] = 0;
     }
+    for (i = 0; i < 4; i++){
+    	midi_cc_dirty[i] = 0;
+    }
+
+    // and the expanded state
+    for (i = 0; i < 128; i++){
+    	midi_velocity[i] = 0;
+    	midi_poly_pressure[i] = 0;
+    }
+    for (i = 0; i < 4; i++){
+    	midi_velocity_dirty[i] = 0;
+    	midi_poly_pressure_dirty[i] = 0;
+    }
+    midi_channel_pressure = 0;
+    midi_pitch_bend = 0x2000;   // centered
+    midi_mod_wheel = 0;
+    midi_state_dirty = 0;
+
+    __enable_irq();
 }
 
 // Set (package-specific) parameters for the Midi instance
@@ -393,7 +706,33 @@ void setParam(unsigned int param, unsigned int val)
             sendFullCommands_ = 0;
         }
     } else if (param == PARAM_CHANNEL_IN) {
-        channelIn_ = val;
+        midi_set_channel(val);
+    }
+}
+
+// one channel (1 - 16), or 0 for all of them
+void midi_set_channel(uint8_t ch)
+{
+    channelIn_ = ch;
+    midi_channel_mask = ch ? (1 << ((ch - 1) & 0x0f)) : 0xFFFF;
+}
+
+// any set of channels, sending goes out on the lowest one (or 16 when
+// listening to all, as before)
+void midi_set_channel_mask(uint16_t mask)
+{
+    uint8_t ch;
+
+    midi_channel_mask = mask;
+    if (mask == 0xFFFF) {
+        channelIn_ = 0;
+        return;
+    }
+    for (ch = 0; ch < 16; ch++) {
+        if (mask & (1 << ch)) {
+            channelIn_ = ch + 1;
+            return;
+        }
     }
 }
 
@@ -416,8 +755,19 @@ void handleNoteOff(unsigned int channel, unsigned int note, unsigned int velocit
 	// unset a binary note on in the bit field of midi_blob
 	i = (note >> 3) & 0xF;
 	j = note & 0x7;
-	midi_blob[i] = midi_blob[i] & ~(1 <<j);
+	midi_back->blob[i] = midi_back->blob[i] & ~(1 <<j);
 	new_midi_flag = 1;
+
+	note &= 0x7f;
+	if (midi_velocity[note]) {
+		midi_velocity[note] = 0;
+		mark_dirty(midi_velocity_dirty, note);
+	}
+	// pressure goes with the note
+	if (midi_poly_pressure[note]) {
+		midi_poly_pressure[note] = 0;
+		mark_dirty(midi_poly_pressure_dirty, note);
+	}
 }
 
 void handleNoteOn(unsigned int channel, unsigned int note, unsigned int velocity) {
@@ -426,49 +776,93 @@ void handleNoteOn(unsigned int channel, unsigned int note, unsigned int velocity
 	// set a binary note on in the bit field of midi_blob
 	i = (note >> 3) & 0xF;
 	j = note & 0x7;
-	midi_blob[i] = midi_blob[i] | (1 <<j);
+	midi_back->blob[i] = midi_back->blob[i] | (1 <<j);
 	new_midi_flag = 1;
+
+	note &= 0x7f;
+	if (midi_velocity[note] != velocity) {
+		midi_velocity[note] = velocity;
+		mark_dirty(midi_velocity_dirty, note);
+	}
 }
 
 void handleSync(void) {
+	midiclock_tick();
+
 	// counting 24 ppq
-	midi_blob[SYNC]++;
-	if (midi_blob[SYNC] == 24) midi_blob[SYNC] = 0;
+	midi_back->blob[SYNC]++;
+	if (midi_back->blob[SYNC] == 24) midi_back->blob[SYNC] = 0;
 	new_midi_flag = 1;
 }
 
 void handleStart(void) {
-	midi_blob[SYNC] = 0;
+	midiclock_start();
+	midi_back->blob[SYNC] = 0;
 	new_midi_flag = 1;
 }
 
 void handleStop(void) {
-
+	midiclock_stop();
 }
 
-void handleVelocityChange(unsigned int channel, unsigned int note, unsigned int velocity) {}
+void handleVelocityChange(unsigned int channel, unsigned int note, unsigned int velocity) {
+	note &= 0x7f;
+	if (midi_poly_pressure[note] != velocity) {
+		midi_poly_pressure[note] = velocity;
+		mark_dirty(midi_poly_pressure_dirty, note);
+	}
+}
 
 void handleControlChange(unsigned int channel, unsigned int controller, unsigned int value) {
-	if (controller == 21) midi_blob[CCK1] = value;
-	if (controller == 22) midi_blob[CCK2] = value;
-	if (controller == 23) midi_blob[CCK3] = value;
-	if (controller == 24) midi_blob[CCK4] = value;
-	if (controller == 25) midi_blob[CCK5] = value;
+	controller &= 0x7f;
+	if (midi_cc[controller] != value) {
+		midi_cc[controller] = value;
+		mark_dirty(midi_cc_dirty, controller);
+	}
+
+	// mod wheel, a new MSB clears the LSB
+	if ((controller == 1) || (controller == 33)) {
+		uint16_t mod = (controller == 1) ? (value << 7) : ((midi_mod_wheel & 0x3f80) | value);
+		if (midi_mod_wheel != mod) {
+			midi_mod_wheel = mod;
+			midi_state_dirty |= MIDI_STATE_MOD_WHEEL;
+		}
+	}
+
+	if (controller == 21) midi_back->blob[CCK1] = value;
+	if (controller == 22) midi_back->blob[CCK2] = value;
+	if (controller == 23) midi_back->blob[CCK3] = value;
+	if (controller == 24) midi_back->blob[CCK4] = value;
+	if (controller == 25) midi_back->blob[CCK5] = value;
 	new_midi_flag = 1;
 }
 
 void handleProgramChange(unsigned int channel, unsigned int program) {
-	midi_blob[PGM] = program;
+	midi_back->blob[PGM] = program;
 	new_midi_flag = 1;
 }
 
-void handleAfterTouch(unsigned int channel, unsigned int velocity) {}
-void handlePitchChange(unsigned int pitch) {}
-void handleSongPosition(unsigned int position) {}
+void handleAfterTouch(unsigned int channel, unsigned int velocity) {
+	if (midi_channel_pressure != velocity) {
+		midi_channel_pressure = velocity;
+		midi_state_dirty |= MIDI_STATE_CHANNEL_PRESSURE;
+	}
+}
+
+void handlePitchChange(unsigned int pitch) {
+	if (midi_pitch_bend != pitch) {
+		midi_pitch_bend = pitch;
+		midi_state_dirty |= MIDI_STATE_PITCH_BEND;
+	}
+}
+void handleSongPosition(unsigned int position) {
+	midiclock_position(position);
+}
 void handleSongSelect(unsigned int song) {}
 void handleTuneRequest(void) {}
 void handleContinue(void) {
-	midi_blob[SYNC] = 0;
+	midiclock_continue();
+	midi_back->blob[SYNC] = 0;
 	new_midi_flag = 1;
 }
 
@@ -33,11 +33,73 @@ uint8_t sendFullCommands_;
 /* Internal functions */
 
 void midi_init(uint8_t ch);
+
+// which channels get through, midi_set_channel() is the old single channel
+// way (0 for all), the mask has bit n set for channel n + 1
+extern uint16_t midi_channel_mask;
+void midi_set_channel(uint8_t ch);
+void midi_set_channel_mask(uint16_t mask);
+
+// what goes back to the host after each frame (/midimode), bits can be combined
+#define MIDI_MODE_SNAPSHOT 1   // midi_blob, state of the notes, 5 CCs, sync and program (/mblob)
+#define MIDI_MODE_EVENTS 2     // every message received since the last reply (/mev)
+#define MIDI_MODE_CC 4         // controllers that changed since the last reply (/mcc)
+#define MIDI_MODE_STATE 8      // velocities, pressure, pitch bend, mod wheel that changed (/mst)
+#define MIDI_MODE_CLOCK 16     // tempo and beat phase from MIDI clock (/clk)
+
+// event list, each event is 5 bytes: tick (2 bytes), status, data 1, data 2
+#define MIDI_EVENT_MAX 32
+#define MIDI_EVENT_SIZE 5
+
+// what the main loop sends back each frame, double buffered since the
+// ISR keeps parsing while a reply goes out
+typedef struct {
+	uint8_t blob[23];     // 16 bytes for note states, 5 bytes CC, 1 byte sync number, 1 byte program
+	uint8_t events[MIDI_EVENT_MAX * MIDI_EVENT_SIZE];   // tick is the low 16 bits of timer_ticks
+	uint8_t event_count;
+	uint16_t events_dropped;   // didn't fit in the list
+} midi_frame_t;
+
+// hands the frame parsed so far to the main loop (also in midi_front) and
+// starts a new one with the same snapshot and an empty event list
+midi_frame_t * midi_frame_swap(void);
+extern midi_frame_t * midi_front;
+
+// add a received message to the event list (if MIDI_MODE_EVENTS is on)
+void midi_event_push(uint8_t status, uint8_t data1, uint8_t data2);
+void midi_events_clear(void);
+
+// fills buf with controller number / value pairs for the CCs that changed,
+// up to max pairs, and returns how many.  the rest go out next time
+uint8_t midi_cc_collect(uint8_t * buf, uint8_t max);
+
+// have every controller sent again (e.g. when the host starts listening)
+void midi_cc_mark_all(void);
+
+// same for the expanded state, records are 3 bytes tagged with a status:
+//   0x90 note, velocity (0 is off)      0xA0 note, poly pressure
+//   0xD0 channel pressure, 0            0xE0 pitch bend LSB, MSB
+//   0xB0 mod wheel LSB, MSB
+uint8_t midi_state_collect(uint8_t * buf, uint8_t max);
+void midi_state_mark_all(void);
 // Handle decoding incoming MIDI traffic a byte at a time -- remembers
 //  what it needs to from one call to the next.
 void recvByte(int byte);
 void put_char(uint8_t c);
 
+// MIDI out (queued, sent by DMA), a whole message with running status,
+// and raw bytes from the host
+void midi_send(uint8_t status, uint8_t data1, uint8_t data2);
+void midi_send_raw(const uint8_t * bytes, uint16_t len);
+
+// soft thru, what gets from MIDI in to MIDI out (/midithru), 0 is off
+#define MIDI_THRU_VOICE 1          // channel messages on the channels in midi_channel_mask
+#define MIDI_THRU_ALL_CHANNELS 2   // ... or on any channel
+#define MIDI_THRU_COMMON 4         // song position, song select, tune request, MTC
+#define MIDI_THRU_REALTIME 8       // clock, start, stop, continue, active sense, reset
+#define MIDI_THRU_SYSEX 16
+extern uint8_t midi_thru;
+
 // Set this parameter to anything other than 0 to cause every MIDI update to
 //  include a copy of the current event (e.g. for every note off to include
 //  the NOTE OFF event) -- by default, if an event is the same type of event as
@@ -106,6 +168,7 @@ void handleReset(void);
 #define STATUS_AFTER_TOUCH 0xD0
 #define STATUS_PITCH_CHANGE 0xE0
 #define STATUS_START_PROPRIETARY 0xF0
+#define STATUS_MTC_QUARTER_FRAME 0xF1
 #define STATUS_SONG_POSITION 0xF2
 #define STATUS_SONG_SELECT 0xF3
 #define STATUS_TUNE_REQUEST 0xF6
@@ -0,0 +1,141 @@
+/*
+ * midiclock.c
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#include "midiclock.h"
+#include "Timer.h"
+
+// Each tick is timestamped as it is parsed in the USART ISR and fed to an alpha-beta
+// filter, which tracks when the next tick is due and the tick period:
+//
+//   err = t - predicted
+//   t_est = predicted + err / 8       (alpha)
+//   period += err / 128               (beta)
+//   predicted = t_est + period
+//
+// This smooths out the jitter of USB-MIDI interfaces and the like while
+// still following tempo changes in a few beats.  A tick far off the
+// prediction (tempo jump, lost ticks) restarts the filter from the raw
+// interval.  The phase is extrapolated from the last estimate, but never
+// past the next tick, so it doesn't run ahead when the clock stops.
+
+#define PERIOD_FRAC 8                 // fractional bits of the period
+#define PERIOD_MIN 2500               // us, 1000 BPM
+#define PERIOD_MAX 125000             // us, 20 BPM
+#define TIMEOUT (PERIOD_MAX * 2)      // us without a tick before losing lock
+
+typedef struct {
+	uint32_t last_tick;               // raw time of the last tick
+	uint32_t t_est;                   // filtered time of the last tick
+	uint32_t period;                  // filtered period, PERIOD_FRAC bits
+	uint32_t position;                // ticks since start, the first one after start is 0
+	uint8_t ticks_seen;               // good ticks in a row, up to 2
+	uint8_t stopped;
+} midiclock_t;
+
+// updated from the ISR
+static midiclock_t clk = { 0, 0, 0, 0xFFFFFFFF, 0, 0 };
+
+void midiclock_tick(void) {
+	uint32_t t = timer_micros();
+	uint32_t interval;
+	uint32_t p;
+	int32_t err;
+
+	interval = t - clk.last_tick;
+	clk.last_tick = t;
+
+	if ((interval < PERIOD_MIN) || (interval > PERIOD_MAX)) {
+		// first tick, or way off
+		clk.ticks_seen = 0;
+		clk.t_est = t;
+	}
+	else if (clk.ticks_seen < 2) {
+		// second good one in a row gives a period to start from
+		clk.period = interval << PERIOD_FRAC;
+		clk.t_est = t;
+		clk.ticks_seen++;
+	}
+	else {
+		p = clk.period >> PERIOD_FRAC;
+		err = (int32_t) (t - (clk.t_est + p));
+
+		if ((err > (int32_t) (p >> 1)) || (err < -(int32_t) (p >> 1))) {
+			// tempo jump or lost ticks, start over from the raw interval
+			clk.period = interval << PERIOD_FRAC;
+			clk.t_est = t;
+		}
+		else {
+			clk.t_est = clk.t_est + p + (err >> 3);
+			clk.period += err * (1 << (PERIOD_FRAC - 7));
+			if (clk.period < (PERIOD_MIN << PERIOD_FRAC)) clk.period = PERIOD_MIN << PERIOD_FRAC;
+			if (clk.period > (PERIOD_MAX << PERIOD_FRAC)) clk.period = PERIOD_MAX << PERIOD_FRAC;
+		}
+	}
+
+	if (!clk.stopped) clk.position++;
+}
+
+void midiclock_start(void) {
+	clk.position = 0xFFFFFFFF;
+	clk.stopped = 0;
+}
+
+void midiclock_continue(void) {
+	clk.stopped = 0;
+}
+
+void midiclock_stop(void) {
+	clk.stopped = 1;
+}
+
+void midiclock_position(uint16_t sixteenths) {
+	// 6 ticks per 16th, the next tick plays the position
+	clk.position = (sixteenths * 6) - 1;
+}
+
+void midiclock_report(uint32_t now, uint32_t * bpm100, uint32_t * beat, uint16_t * phase, uint8_t * flags) {
+	uint32_t p;
+	uint32_t elapsed;
+	uint32_t in_beat;
+	midiclock_t c;
+
+	// the ISR updates these, take a copy that goes together
+	__disable_irq();
+	c = clk;
+	__enable_irq();
+
+	*flags = 0;
+	if ((c.ticks_seen >= 2) && ((int32_t) (now - c.last_tick) < TIMEOUT)) *flags |= MIDICLOCK_LOCKED;
+	if (!c.stopped) *flags |= MIDICLOCK_RUNNING;
+
+	if (c.ticks_seen < 2) {
+		*bpm100 = 0;
+		*beat = 0;
+		*phase = 0;
+		return;
+	}
+
+	// 60 s * 100 / 24 ticks = 250000000 / us per tick
+	*bpm100 = (uint32_t) ((250000000ull << PERIOD_FRAC) / c.period);
+
+	if (c.position == 0xFFFFFFFF) {
+		// started but no tick yet, sitting on the downbeat
+		*beat = 0;
+		*phase = 0;
+		return;
+	}
+
+	*beat = c.position / MIDICLOCK_PPQ;
+	in_beat = c.position % MIDICLOCK_PPQ;
+
+	// how far along to the next tick, held just short of it
+	p = c.period >> PERIOD_FRAC;
+	elapsed = c.stopped ? 0 : (now - c.t_est);
+	if ((int32_t) elapsed < 0) elapsed = 0;
+	if (elapsed >= p) elapsed = p - 1;
+
+	*phase = (uint16_t) ((((uint64_t) in_beat * p + elapsed) << 16) / ((uint64_t) p * MIDICLOCK_PPQ));
+}
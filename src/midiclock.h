@@ -0,0 +1,31 @@
+/*
+ * midiclock.h
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#ifndef MIDICLOCK_H_
+#define MIDICLOCK_H_
+
+#include <stdint.h>
+
+// tempo and beat phase from MIDI clock (24 ticks per beat)
+
+#define MIDICLOCK_PPQ 24
+
+// report flags
+#define MIDICLOCK_LOCKED 1     // clock is coming in and the tempo is good
+#define MIDICLOCK_RUNNING 2    // the beat is moving (no stop, or start / continue since)
+
+// from the parser (in the USART ISR) as the bytes come in
+void midiclock_tick(void);
+void midiclock_start(void);
+void midiclock_continue(void);
+void midiclock_stop(void);
+void midiclock_position(uint16_t sixteenths);
+
+// tempo (BPM * 100), beats since start, phase in the beat (0 - 65535) and
+// flags, extrapolated to now (timer_micros())
+void midiclock_report(uint32_t now, uint32_t * bpm100, uint32_t * beat, uint16_t * phase, uint8_t * flags);
+
+#endif /* MIDICLOCK_H_ */
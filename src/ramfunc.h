@@ -0,0 +1,17 @@
+/*
+ * ramfunc.h
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#ifndef RAMFUNC_H_
+#define RAMFUNC_H_
+
+// functions marked with this are linked into .ramfunc (sections.ld), copied to RAM
+// with .data at startup and run from there.  flash runs with a wait state at 48 MHz,
+// so this is for the per byte paths.  RAM is short, keep it to small hot functions.
+// flash and RAM are too far apart for a BL, the linker puts a veneer on calls
+// between them, so hot paths should mostly call each other.
+#define RAMFUNC __attribute__((section(".ramfunc"), noinline))
+
+#endif /* RAMFUNC_H_ */
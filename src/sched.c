@@ -0,0 +1,105 @@
+/*
+ * sched.c
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#include <string.h>
+#include "sched.h"
+
+typedef struct {
+	uint64_t at;
+	uint8_t len;
+	uint8_t msg[SCHED_MSG_MAX];
+} sched_slot_t;
+
+// order[] has the slots in time order, first one is next to go,
+// so the messages never move, only their slot numbers do
+static sched_slot_t slots[SCHED_SLOTS];
+static uint8_t order[SCHED_SLOTS];
+static uint8_t queued = 0;
+static uint8_t peak = 0;
+
+static uint32_t run = 0;
+static uint32_t full = 0;
+static uint32_t past = 0;
+static uint32_t late_max = 0;
+static uint32_t late8 = 0;     // 3 fractional bits, moves 1/8 of the way each time
+
+uint8_t sched_add(uint64_t at, uint64_t now, const uint8_t * msg, uint8_t len) {
+	uint8_t slot, i, used = 0;
+
+	if ((len == 0) || (len > SCHED_MSG_MAX)) return 0;
+	if (queued == SCHED_SLOTS) {
+		full++;
+		return 0;
+	}
+
+	// the free slot is the one no entry of order[] points at
+	for (slot = 0; slot < SCHED_SLOTS; slot++) {
+		used = 0;
+		for (i = 0; i < queued; i++) if (order[i] == slot) used = 1;
+		if (!used) break;
+	}
+
+	slots[slot].at = at;
+	slots[slot].len = len;
+	memcpy(slots[slot].msg, msg, len);
+	if (at <= now) past++;
+
+	// after anything due at the same time, so those keep their order
+	i = queued;
+	while ((i > 0) && (slots[order[i - 1]].at > at)) {
+		order[i] = order[i - 1];
+		i--;
+	}
+	order[i] = slot;
+
+	queued++;
+	if (queued > peak) peak = queued;
+	return 1;
+}
+
+uint8_t sched_pending(void) {
+	return queued;
+}
+
+uint8_t sched_get(uint64_t now, uint8_t ** msg) {
+	sched_slot_t * s;
+	uint32_t late;
+
+	if (!queued) return 0;
+	s = &slots[order[0]];
+	if (s->at > now) return 0;
+
+	late = ((now - s->at) > 0xFFFFFFFF) ? 0xFFFFFFFF : (uint32_t) (now - s->at);
+	if (late > late_max) late_max = late;
+	// one from the past would only drag the average around
+	if (late < 1000000) late8 += (int32_t) ((late << 3) - late8) / 8;
+	run++;
+
+	*msg = s->msg;
+	return s->len;
+}
+
+void sched_release(void) {
+	uint8_t i;
+
+	if (!queued) return;
+	queued--;
+	for (i = 0; i < queued; i++) order[i] = order[i + 1];
+}
+
+void sched_clear(void) {
+	queued = 0;
+}
+
+void sched_stats(sched_stats_t * stats) {
+	stats->run = run;
+	stats->full = full;
+	stats->past = past;
+	stats->late_max = late_max;
+	stats->late_avg = late8 >> 3;
+	stats->queued = queued;
+	stats->peak = peak;
+}
@@ -0,0 +1,43 @@
+/*
+ * sched.h
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#ifndef SCHED_H_
+#define SCHED_H_
+
+#include <stdint.h>
+
+// OSC messages held until a set time (controller time, timer_micros64()),
+// kept in time order.  the main loop asks for the first one when it is due,
+// dispatches it like it just came in and then lets it go.
+
+#define SCHED_SLOTS 4
+#define SCHED_MSG_MAX 32       // bytes, enough for an address and a few args
+
+typedef struct {
+	uint32_t run;          // messages dispatched
+	uint32_t full;         // turned away, no slot free
+	uint32_t past;         // already due when they arrived
+	uint32_t late_max;     // us after its time the latest one ran
+	uint32_t late_avg;     // us, averaged over the last few
+	uint8_t queued;
+	uint8_t peak;
+} sched_stats_t;
+
+// returns 0 if it didn't fit
+uint8_t sched_add(uint64_t at, uint64_t now, const uint8_t * msg, uint8_t len);
+
+// returns 1 if something is queued at all, cheap enough for every loop pass
+uint8_t sched_pending(void);
+
+// returns the length of the first message if it is due (0 if not) and points
+// msg at it, it stays put until sched_release()
+uint8_t sched_get(uint64_t now, uint8_t ** msg);
+void sched_release(void);
+
+void sched_clear(void);
+void sched_stats(sched_stats_t * stats);
+
+#endif /* SCHED_H_ */
@@ -3,25 +3,71 @@
 #include "Timer.h"
 
 uint8_t pix_buf[1024];
-extern uint8_t spi_out_buf_remaining;
+
+// columns touched since each page last went out, clean when lo > hi
+static uint8_t dirty_lo[8];
+static uint8_t dirty_hi[8];
+
+// refresh runs from ssd1306_poll(), a page at a time:
+// the 6 byte address window goes out with DC low, then the dirty columns with DC high,
+// both by DMA on channel 3 so the main loop only sets them up
+#define XFER_IDLE 0
+#define XFER_CMD 1
+#define XFER_DATA 2
+static uint8_t xfer_state = XFER_IDLE;
+static uint8_t xfer_page;
+static uint8_t xfer_lo;
+static uint8_t xfer_hi;
+static uint8_t xfer_cmd[6];
+static uint32_t xfer_frame_start;
+static uint16_t xfer_frame_bytes;
+static uint8_t xfer_frame_pages;
+
+ssd1306_stats_t ssd1306_stats;
 
 //  line = pgm_read_byte(font+(c*5)+i);
 
 uint8_t put_char_small(unsigned char c, uint8_t y, uint8_t x) {
-	uint8_t i, j;
+	uint8_t i;
 	//c -= 32;
-	for (i = 0; i < 5; i++) {
-		for (j = 0; j < 8; j++) {
-			//if ((characters[(c * 5) + i] >> j) & 0x01)
-			if ((font[(c * 5) + i] >> j) & 0x01)
-				put_pixel(1, y + i, x + j);
-			else
-				put_pixel(0, y + i, x + j);
-		}
-	}
+	for (i = 0; i < 5; i++)
+		put_column(font[(c * 5) + i], y + i, x);
 	return 5;
 }
 
+static void mark_dirty(uint8_t page, uint8_t lo, uint8_t hi) {
+	if (lo < dirty_lo[page]) dirty_lo[page] = lo;
+	if (hi > dirty_hi[page]) dirty_hi[page] = hi;
+}
+
+// replace the masked bits of one pix_buf byte
+static void put_bits(uint8_t page, uint8_t column, uint8_t mask, uint8_t bits) {
+	uint8_t * p = &pix_buf[(page * 128) + column];
+	uint8_t tmp8 = (*p & ~mask) | (bits & mask);
+	if (tmp8 != *p) {
+		*p = tmp8;
+		mark_dirty(page, column, column);
+	}
+}
+
+// 8 pixels going down from (x, y), bit 0 at the top, same wrap as put_pixel.
+// text on a page boundary is one byte, otherwise it is split over two pages
+void put_column(uint8_t bits, uint8_t x, uint8_t y) {
+	uint8_t page, shift;
+
+	x &= 0x7f;
+	y &= 0x3f;
+	page = y / 8;
+	shift = y & 0x7;
+
+	if (!shift) {
+		put_bits(page, x, 0xFF, bits);
+	} else {
+		put_bits(page, x, 0xFF << shift, bits << shift);
+		put_bits((page + 1) & 0x7, x, 0xFF >> (8 - shift), bits >> (8 - shift));
+	}
+}
+
 void put_pixel(uint8_t on, uint8_t x, uint8_t y) {
 
 	uint8_t page = 0;
@@ -48,7 +94,60 @@ void put_pixel(uint8_t on, uint8_t x, uint8_t y) {
 		// tmp8 &= ~(1 << (7 - (y & 0x7)));
 	}
 
-	pix_buf[(page * 128) + column] = tmp8;
+	// only bytes that actually change have to go out again
+	if (tmp8 != pix_buf[(page * 128) + column]) {
+		pix_buf[(page * 128) + column] = tmp8;
+		mark_dirty(page, column, column);
+	}
+}
+
+// rectangle clipped to the screen, no wrap
+void ssd1306_fill_rect(uint8_t x, uint8_t y, uint8_t w, uint8_t h, uint8_t on) {
+	uint8_t x1, y1, page, mask, column;
+
+	if ((x >= SSD1306_LCDWIDTH) || (y >= SSD1306_LCDHEIGHT)) return;
+	x1 = ((x + w) > SSD1306_LCDWIDTH) ? SSD1306_LCDWIDTH : x + w;
+	y1 = ((y + h) > SSD1306_LCDHEIGHT) ? SSD1306_LCDHEIGHT : y + h;
+
+	for (page = y / 8; page <= (y1 - 1) / 8; page++) {
+		if (y1 <= y) break;
+		mask = 0xFF;
+		if (page == y / 8) mask &= 0xFF << (y & 0x7);
+		if (page == (y1 - 1) / 8) mask &= 0xFF >> (7 - ((y1 - 1) & 0x7));
+		for (column = x; column < x1; column++)
+			put_bits(page, column, mask, on ? 0xFF : 0);
+	}
+}
+
+void ssd1306_clear(void) {
+	ssd1306_fill_rect(0, 0, SSD1306_LCDWIDTH, SSD1306_LCDHEIGHT, 0);
+}
+
+// unpack run length coded bytes (ssd1306.h) into pix_buf from offset on,
+// with flip set they are XORed into what is there instead of replacing it.
+// returns the number of pix_buf bytes covered, stops at a truncated run or the end of pix_buf
+uint16_t ssd1306_put_rle(uint16_t offset, const uint8_t * rle, uint16_t len, uint8_t flip) {
+	uint16_t i = 0;
+	uint16_t start = offset;
+	uint8_t c, n, b, literal;
+
+	while ((i < len) && (offset < sizeof(pix_buf))) {
+		c = rle[i++];
+		literal = (c < 128);
+		n = literal ? c + 1 : c - 125;
+		if (!literal) {
+			if (i >= len) break;
+			b = rle[i++];
+		} else if ((i + n) > len) {
+			break;
+		}
+		for (; n && (offset < sizeof(pix_buf)); n--, offset++) {
+			if (literal) b = rle[i++];
+			if (flip && !b) continue;   // the usual case, nothing changed here
+			put_bits(offset / 128, offset & 0x7f, 0xFF, flip ? pix_buf[offset] ^ b : b);
+		}
+	}
+	return offset - start;
 }
 
 void ssd1306_cs(uint8_t stat) {
@@ -87,41 +186,29 @@ void ssd1306_sck(uint8_t stat) {
 		GPIO_ResetBits(GPIOA, GPIO_Pin_5);
 }
 
+// CMD and DATA block, they are only for init, the refresh goes by DMA
 void CMD(uint8_t c) {
-/*	ssd1306_cs(1);
+	ssd1306_cs(1);
 	ssd1306_dc(0);
 	ssd1306_cs(0);
 	ssd1306_send_byte(c);
-	ssd1306_cs(1);*/
-
+	ssd1306_cs(1);
 }
 
 void DATA(uint8_t c) {
-/*	ssd1306_cs(1);
+	ssd1306_cs(1);
 	ssd1306_dc(1);
 	ssd1306_cs(0);
 	ssd1306_send_byte(c);
-	ssd1306_cs(1);*/
+	ssd1306_cs(1);
 }
 
 void ssd1306_send_byte(uint8_t byte) {
-
-/*	SPI_SendData8(SPI1, byte);
-	while (SPI_I2S_GetFlagStatus(SPI1, SPI_I2S_FLAG_BSY))*/
+	while (SPI_I2S_GetFlagStatus(SPI1, SPI_I2S_FLAG_TXE) == RESET)
+		;
+	SPI_SendData8(SPI1, byte);
+	while (SPI_I2S_GetFlagStatus(SPI1, SPI_I2S_FLAG_BSY))
 		;   // wait till done sending
-
-	/*  for (i=7; i>=0; i--)
-	 * 	int8_t i;
-	 {
-	 // Set clock pin low
-	 ssd1306_sck(0);
-	 // Set data pin high or low depending on the value of the current bit
-	 if (byte & (1 << i)) ssd1306_mosi(1);
-	 else ssd1306_mosi(0);
-	 // Set clock pin high
-	 ssd1306_sck(1);
-	 }
-	 ssd1306_sck(0);*/
 }
 
 void ssd1306_init(uint8_t vccstate) {
@@ -132,9 +219,6 @@ void ssd1306_init(uint8_t vccstate) {
 	for (i = 0; i < 1024; i++)
 		pix_buf[i] = 0;
 
-	// CMD(0xAA);
-	// for(;;);
-
 	// Reset the LCD
 	ssd1306_rst(1);
 	timer_sleep(5);
@@ -185,62 +269,111 @@ void ssd1306_init(uint8_t vccstate) {
 
 	// Enabled the OLED panel
 	CMD(SSD1306_DISPLAYON);
+
+	// whatever is in the panel RAM after reset gets cleared on the first poll
+	xfer_state = XFER_IDLE;
+	ssd1306_refresh();
 }
 
+// the whole screen goes out again
 void ssd1306_refresh(void) {
+	uint8_t page;
+	for (page = 0; page < 8; page++)
+		mark_dirty(page, 0, 127);
+}
 
-	uint8_t byte;
-
-	CMD(SSD1306_SETLOWCOLUMN | 0x0);  // low col = 0
-	CMD(SSD1306_SETHIGHCOLUMN | 0x0);  // hi col = 0
-	CMD(SSD1306_SETSTARTLINE | 0x0); // line #0
-
-	ssd1306_cs(1);
-	ssd1306_dc(1);
-	ssd1306_cs(0);
-
-	// send it all at once
-	uint16_t i;
-	for (i = 0; i < 1024; i++) {
-
-		byte = pix_buf[i];
+void ssd1306_refresh_line(uint8_t page) {
+	page &= 0x7;
+	mark_dirty(page, 0, 127);
+}
 
-		SPI_SendData8(SPI1, byte);
-		while (SPI_I2S_GetFlagStatus(SPI1, SPI_I2S_FLAG_BSY))
-			;   // wait till done sending
+uint8_t ssd1306_busy(void) {
+	uint8_t page;
+	if (xfer_state != XFER_IDLE) return 1;
+	for (page = 0; page < 8; page++)
+		if (dirty_lo[page] <= dirty_hi[page]) return 1;
+	return 0;
+}
 
-	}
-	ssd1306_cs(1);
+static void xfer_start(const uint8_t * buf, uint16_t len) {
+	DMA_Cmd(DMA1_Channel3, DISABLE);
+	DMA_ClearFlag(DMA1_FLAG_GL3);
+	DMA1_Channel3->CMAR = (uint32_t) buf;
+	DMA_SetCurrDataCounter(DMA1_Channel3, len);
+	DMA_Cmd(DMA1_Channel3, ENABLE);
 }
 
-void ssd1306_refresh_line(uint8_t page) {
-	page &= 0x7;
-	CMD(SSD1306_SETLOWCOLUMN | 0x0);  // low col = 0
-	CMD(SSD1306_SETHIGHCOLUMN | 0x0);  // hi col = 0
-	CMD(SSD1306_SETSTARTPAGE | page); // page 0 - 7
+// the last byte is still shifting out when the DMA completes, DC and CS wait for BSY
+static uint8_t xfer_done(void) {
+	if (DMA_GetFlagStatus(DMA1_FLAG_TC3) == RESET) return 0;
+	if (SPI_I2S_GetFlagStatus(SPI1, SPI_I2S_FLAG_BSY)) return 0;
+	return 1;
+}
 
-	static uint8_t c;
-	c++;
-	c &= 1;
+// start the next dirty page at or after xfer_page, returns 0 when there are none left
+static uint8_t xfer_next_page(void) {
+	for (; xfer_page < 8; xfer_page++) {
+		if (dirty_lo[xfer_page] <= dirty_hi[xfer_page]) break;
+	}
+	if (xfer_page == 8) return 0;
+
+	// clear it before sending, anything drawn while the DMA runs marks it again
+	xfer_lo = dirty_lo[xfer_page];
+	xfer_hi = dirty_hi[xfer_page];
+	dirty_lo[xfer_page] = 0xFF;
+	dirty_hi[xfer_page] = 0;
+
+	// horizontal addressing (set in init), so the window is a column range on one page
+	xfer_cmd[0] = SSD1306_COLUMNADDR;
+	xfer_cmd[1] = xfer_lo;
+	xfer_cmd[2] = xfer_hi;
+	xfer_cmd[3] = SSD1306_PAGEADDR;
+	xfer_cmd[4] = xfer_page;
+	xfer_cmd[5] = xfer_page;
 
-	ssd1306_cs(1);
-	ssd1306_dc(1);
+	ssd1306_dc(0);
 	ssd1306_cs(0);
+	xfer_start(xfer_cmd, sizeof(xfer_cmd));
+	xfer_state = XFER_CMD;
+	return 1;
+}
 
-	uint16_t i;
-	uint8_t byte;
-	for (i = 0; i < 128; i++) {
+// call this every pass of the main loop, it never waits on the SPI
+void ssd1306_poll(void) {
+
+	if (xfer_state == XFER_IDLE) {
+		xfer_page = 0;
+		if (!xfer_next_page()) return;
+		xfer_frame_start = timer_micros();
+		xfer_frame_bytes = 0;
+		xfer_frame_pages = 0;
+		return;
+	}
 
-		byte = pix_buf[i + (page * 128)];
-		//spi_out_buf[i] = byte;
+	if (!xfer_done()) return;
 
-		SPI_SendData8(SPI1, byte);
-		while (SPI_I2S_GetFlagStatus(SPI1, SPI_I2S_FLAG_BSY))
-			;   // wait till done sending
+	if (xfer_state == XFER_CMD) {
+		ssd1306_dc(1);
+		xfer_start(&pix_buf[(xfer_page * 128) + xfer_lo], xfer_hi - xfer_lo + 1);
+		xfer_state = XFER_DATA;
+		return;
 	}
 
-	spi_out_buf_remaining = 128;
+	// page done
 	ssd1306_cs(1);
+	xfer_frame_bytes += sizeof(xfer_cmd) + xfer_hi - xfer_lo + 1;
+	xfer_frame_pages++;
+	xfer_page++;
+	if (xfer_next_page()) return;
+
+	// nothing left that was dirty when the refresh started
+	xfer_state = XFER_IDLE;
+	ssd1306_stats.frames++;
+	ssd1306_stats.last_bytes = xfer_frame_bytes;
+	ssd1306_stats.last_pages = xfer_frame_pages;
+	ssd1306_stats.last_us = timer_micros() - xfer_frame_start;
+	if (ssd1306_stats.last_us > ssd1306_stats.max_us) ssd1306_stats.max_us = ssd1306_stats.last_us;
+	ssd1306_stats.total_bytes += xfer_frame_bytes;
 }
 
 void println_16(char * line, int len, int x, int y) {
@@ -271,10 +404,10 @@ void println_8_spacy(char * line, int len, int x, int y) {
 unsigned int put_char_arial16(unsigned char character, unsigned int y,
 		unsigned int x, unsigned int color) {
 	int i;
-	int j;
 	int k;
 	int charWidth;
 	int charOffset;
+	const unsigned char * glyph;
 
 	if (character == 32)
 		return 4;
@@ -283,15 +416,12 @@ unsigned int put_char_arial16(unsigned char character, unsigned int y,
 
 	charWidth = arial16Width[character + 1];
 	charOffset = arial16Offset[character] * 2;
+	glyph = &arial16[charOffset];
 
+	// top 8 rows are the first charWidth bytes, then the bottom 8
 	for (i = 0; i < 2; i++) {
-		for (j = 0; j < 8; j++) {
-			for (k = 0; k < charWidth; k++) {
-				if ((arial16[charOffset + k + (i * charWidth)] >> j) & 0x01)
-					put_pixel(color, (y + k), (x + (i * 8) + j));
-				else
-					put_pixel(0, (y + k), (x + (i * 8) + j));
-			}
+		for (k = 0; k < charWidth; k++) {
+			put_column(color ? glyph[k + (i * charWidth)] : 0, y + k, x + (i * 8));
 		}
 	}
 	return charWidth + 1;
@@ -1,5 +1,5 @@
 #ifndef SSD1306_H_
-#define SSD1306_
+#define SSD1306_H_
 
 #include "stm32f0xx.h"
 
@@ -27,6 +27,8 @@
 #define SSD1306_SETSTARTLINE              0x40
 #define SSD1306_SETSTARTPAGE              0xB0
 #define SSD1306_MEMORYMODE                0x20
+#define SSD1306_COLUMNADDR                0x21
+#define SSD1306_PAGEADDR                  0x22
 #define SSD1306_COMSCANINC                0xC0
 #define SSD1306_COMSCANDEC                0xC8
 #define SSD1306_SEGREMAP                  0xA0
@@ -34,10 +36,36 @@
 #define SSD1306_EXTERNALVCC               0x1
 #define SSD1306_SWITCHCAPVCC              0x2
 
+// refresh cost, a frame is one pass over the pages that were dirty
+typedef struct {
+	uint32_t frames;
+	uint32_t total_bytes;   // on the SPI, address windows included
+	uint16_t last_bytes;
+	uint8_t last_pages;
+	uint32_t last_us;       // first page started to last page done
+	uint32_t max_us;
+} ssd1306_stats_t;
+
+extern ssd1306_stats_t ssd1306_stats;
+
 // Initialisation/Config Prototypes
 void ssd1306_init(uint8_t vccstate);
+
+// drawing only marks pix_buf dirty, ssd1306_poll() sends the dirty column
+// range of each page by DMA, these just mark everything (or a page) dirty
 void ssd1306_refresh(void);
 void ssd1306_refresh_line(uint8_t page);
+void ssd1306_poll(void);
+uint8_t ssd1306_busy(void);
+
+// drawing, all of these mark what they change dirty
+void ssd1306_fill_rect(uint8_t x, uint8_t y, uint8_t w, uint8_t h, uint8_t on);
+void ssd1306_clear(void);
+
+// run length coding for pix_buf bytes (page 0 columns 0 - 127, then page 1 ...):
+//   0 - 127    that many plus 1 bytes follow as they are
+//   128 - 255  the next byte repeats that many minus 125 times (3 - 130)
+uint16_t ssd1306_put_rle(uint16_t offset, const uint8_t * rle, uint16_t len, uint8_t flip);
 
 void ssd1306_cs(uint8_t stat);
 
@@ -57,6 +85,7 @@ void ssd1306_send_byte(uint8_t byte);
 
 uint8_t put_char_small(unsigned char c, uint8_t y, uint8_t x);
 void put_pixel(uint8_t on, uint8_t x, uint8_t y);
+void put_column(uint8_t bits, uint8_t x, uint8_t y);
 unsigned int put_char_arial16(unsigned char character, unsigned int y, unsigned int x, unsigned int color);
 
 void println_16(char * line, int len, int x, int y);
@@ -0,0 +1,73 @@
+/*
+ * sysex.c
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#include "stm32f0xx.h"
+#include "sysex.h"
+
+// two buffers, the ISR fills one while the main loop works on the other,
+// if the main loop hasn't let go of its one when a new message is done
+// the new one is dropped (and counted)
+static uint8_t sysex_buf[2][SYSEX_MAX];
+static uint8_t capture = 0;            // buffer the ISR is filling
+static uint8_t capture_len = 0;
+static uint8_t capture_flags = 0;
+static uint8_t capturing = 0;
+
+static volatile uint8_t ready = 0;     // the other buffer holds a message for the main loop
+static uint8_t ready_len;
+static uint8_t ready_flags;
+static uint16_t dropped = 0;
+
+void sysex_start(void) {
+	sysex_buf[capture][0] = 0xF0;
+	capture_len = 1;
+	capture_flags = 0;
+	capturing = 1;
+}
+
+void sysex_byte(uint8_t byte) {
+	if (!capturing) return;
+
+	// keep the last spot for the F7
+	if (capture_len < (SYSEX_MAX - 1)) sysex_buf[capture][capture_len++] = byte;
+	else capture_flags |= SYSEX_TRUNCATED;
+}
+
+void sysex_end(uint8_t terminated) {
+	if (!capturing) return;
+	capturing = 0;
+
+	sysex_buf[capture][capture_len++] = 0xF7;
+	if (!terminated) capture_flags |= SYSEX_UNTERMINATED;
+
+	if (ready) {
+		if (dropped < 0xFFFF) dropped++;
+		return;
+	}
+	ready_len = capture_len;
+	ready_flags = capture_flags;
+	capture ^= 1;
+	ready = 1;
+}
+
+uint8_t sysex_get(uint8_t ** msg, uint8_t * flags, uint16_t * lost) {
+	if (!ready) return 0;
+
+	*msg = sysex_buf[capture ^ 1];
+	*flags = ready_flags;
+
+	// the ISR counts into it, don't lose one between the read and the reset
+	__disable_irq();
+	*lost = dropped;
+	dropped = 0;
+	__enable_irq();
+
+	return ready_len;
+}
+
+void sysex_release(void) {
+	ready = 0;
+}
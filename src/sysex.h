@@ -0,0 +1,39 @@
+/*
+ * sysex.h
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#ifndef SYSEX_H_
+#define SYSEX_H_
+
+#include <stdint.h>
+
+// incoming SysEx, captured by the parser (USART1 ISR) and handed to the
+// main loop one whole message at a time
+
+#define SYSEX_MAX 64           // bytes kept, F0 and F7 included
+
+// flags
+#define SYSEX_TRUNCATED 1      // longer than SYSEX_MAX, the end got cut off (F7 is still there)
+#define SYSEX_UNTERMINATED 2   // ended by some other status instead of F7
+
+// our own messages, for setting things up from a MIDI editor
+// F0 7D 45 <command> ... F7  (7D is the non-commercial ID, 45 is 'E')
+#define SYSEX_ID_NONCOMMERCIAL 0x7D
+#define SYSEX_ID_ETC 0x45
+#define SYSEX_CMD_SET 0x01     // key, value (3 x 7 bit, low first)
+#define SYSEX_CMD_GET 0x02     // key, answered with SYSEX_CMD_VALUE
+#define SYSEX_CMD_VALUE 0x03   // key, value (3 x 7 bit, low first)
+
+// from the parser
+void sysex_start(void);
+void sysex_byte(uint8_t byte);
+void sysex_end(uint8_t terminated);
+
+// from the main loop, returns the length of a complete message (0 if
+// none) and points msg at it, it stays put until sysex_release()
+uint8_t sysex_get(uint8_t ** msg, uint8_t * flags, uint16_t * dropped);
+void sysex_release(void);
+
+#endif /* SYSEX_H_ */
@@ -0,0 +1,57 @@
+/*
+ * timesync.c
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#include "timesync.h"
+
+static uint8_t sync_valid = 0;
+static uint64_t sync_ctrl;    // controller and host time at the same instant
+static uint64_t sync_host;
+static int32_t sync_drift;    // host runs this many ppb faster than the controller
+
+void timesync_set(uint64_t ctrl_us, uint64_t host_us, int32_t drift_ppb) {
+	if (drift_ppb > TIMESYNC_DRIFT_MAX) drift_ppb = TIMESYNC_DRIFT_MAX;
+	if (drift_ppb < -TIMESYNC_DRIFT_MAX) drift_ppb = -TIMESYNC_DRIFT_MAX;
+	sync_ctrl = ctrl_us;
+	sync_host = host_us;
+	sync_drift = drift_ppb;
+	sync_valid = 1;
+}
+
+uint8_t timesync_valid(void) {
+	return sync_valid;
+}
+
+uint64_t timesync_host_micros(uint64_t ctrl_us) {
+	int64_t d;
+
+	if (!sync_valid) return ctrl_us;
+
+	// days away from the sync point at the largest drift still fits in 64 bits
+	d = (int64_t) (ctrl_us - sync_ctrl);
+	return sync_host + d + ((d * sync_drift) / 1000000000LL);
+}
+
+// the other way, for times the host asks for things to happen at
+uint64_t timesync_ctrl_micros(uint64_t host_us) {
+	int64_t d;
+
+	if (!sync_valid) return host_us;
+
+	// host time runs (1e9 + drift) / 1e9 as fast, so divide that back out.  taking
+	// the drift off the host side instead is out by d * drift^2, 3.6 ms an hour out at 1000 ppm
+	d = (int64_t) (host_us - sync_host);
+	return sync_ctrl + d - ((d * sync_drift) / (1000000000LL + sync_drift));
+}
+
+void timesync_to_ntp(uint64_t us, uint32_t * seconds, uint32_t * fraction) {
+	*seconds = us / 1000000ULL;
+	*fraction = (67108864ULL * (uint32_t) (us % 1000000ULL)) / 15625;   // 2^32 / 1000000
+}
+
+uint64_t timesync_from_ntp(uint32_t seconds, uint32_t fraction) {
+	// rounded to the nearest microsecond so a round trip comes back the same
+	return ((uint64_t) seconds * 1000000ULL) + ((((uint64_t) fraction * 15625) + (1 << 25)) >> 26);
+}
@@ -0,0 +1,28 @@
+/*
+ * timesync.h
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#ifndef TIMESYNC_H_
+#define TIMESYNC_H_
+
+#include <stdint.h>
+
+// host time from controller time (timer_micros64()).
+// the host works out the relation from /sync exchanges (NTP style, see main.cpp)
+// and sends it back with /sync/set, a pair of matching times and the drift.
+// until then host time is just controller time.
+
+#define TIMESYNC_DRIFT_MAX 1000000   // ppb, 1000 ppm is way past any crystal
+
+void timesync_set(uint64_t ctrl_us, uint64_t host_us, int32_t drift_ppb);
+uint8_t timesync_valid(void);
+uint64_t timesync_host_micros(uint64_t ctrl_us);
+uint64_t timesync_ctrl_micros(uint64_t host_us);
+
+// NTP format (OSC timetags), seconds and 1/2^32 seconds
+void timesync_to_ntp(uint64_t us, uint32_t * seconds, uint32_t * fraction);
+uint64_t timesync_from_ntp(uint32_t seconds, uint32_t fraction);
+
+#endif /* TIMESYNC_H_ */
@@ -7,20 +7,38 @@
 
 #include "uart.h"
 #include "BlinkLed.h"
+#include "ramfunc.h"
+#include "cycles.h"
+
+// midi.c, MIDI is parsed right in the ISR
+void recvByte(int byte);
 
 uint8_t uart2_recv_buf[UART2_BUFFER_SIZE];
 uint16_t uart2_recv_buf_head = 0;
 uint16_t uart2_recv_buf_tail = 0;
+uint16_t uart2_recv_peak = 0;    // most bytes ever waiting, for /stats
+uint32_t uart2_overruns = 0;
+uint32_t uart2_recv_dropped = 0;  // bytes that came in with the ring full
+volatile uint32_t uart2_eot_micros = 0;   // when the last SLIP END byte came in, for /sync
+
+// MIDI out, DMA1 channel 2 sends from tail up to head (or the end of the buffer)
+static uint8_t uart1_send_buf[UART1_SEND_BUFFER_SIZE];
+static volatile uint16_t uart1_send_buf_head = 0;
+static volatile uint16_t uart1_send_buf_tail = 0;
+static volatile uint16_t uart1_send_dma_len = 0;   // 0 when DMA is idle
+uint16_t uart1_send_peak = 0;     // most bytes ever queued
+uint32_t uart1_send_dropped = 0;  // uart1_queue calls that didn't fit
+
+isr_cycles_t isr_cycles_host;
+isr_cycles_t isr_cycles_midi;
 
-uint8_t uart1_recv_buf[UART2_BUFFER_SIZE];
-uint16_t uart1_recv_buf_head = 0;
-uint16_t uart1_recv_buf_tail = 0;
 
 void uart2_init(void) {
 
 	USART_InitTypeDef USART_InitStructure;
 	GPIO_InitTypeDef GPIO_InitStructure;
 	NVIC_InitTypeDef NVIC_InitStructure;
+	DMA_InitTypeDef DMA_InitStructure;
 
 	GPIO_StructInit(&GPIO_InitStructure);
 	USART_StructInit(&USART_InitStructure);
@@ -76,10 +94,10 @@ void uart2_init(void) {
 	RCC_APB2PeriphClockCmd(RCC_APB2Periph_USART1, ENABLE);
 
 	GPIO_PinAFConfig(GPIOB, GPIO_PinSource7, GPIO_AF_0);
-	//GPIO_PinAFConfig(GPIOB, GPIO_PinSource6, GPIO_AF_0);
+	GPIO_PinAFConfig(GPIOB, GPIO_PinSource6, GPIO_AF_0);
 
-	//Configure USART1 pins:  Rx ----------------------------
-	GPIO_InitStructure.GPIO_Pin = GPIO_Pin_7 /*| GPIO_Pin_6*/;
+	//Configure USART1 pins:  Rx and Tx ----------------------------
+	GPIO_InitStructure.GPIO_Pin = GPIO_Pin_7 | GPIO_Pin_6;
 	GPIO_InitStructure.GPIO_Speed = GPIO_Speed_50MHz;
 	GPIO_InitStructure.GPIO_Mode = GPIO_Mode_AF;
 	GPIO_InitStructure.GPIO_OType = GPIO_OType_PP;
@@ -93,9 +111,33 @@ void uart2_init(void) {
 	USART_InitStructure.USART_Parity = USART_Parity_No;
 	USART_InitStructure.USART_HardwareFlowControl =
 			USART_HardwareFlowControl_None;
-	USART_InitStructure.USART_Mode = USART_Mode_Rx /*| USART_Mode_Tx*/;
+	USART_InitStructure.USART_Mode = USART_Mode_Rx | USART_Mode_Tx;
 	USART_Init(USART1, &USART_InitStructure);
 
+	// MIDI out by DMA, the address and length are set for each chunk
+	RCC_AHBPeriphClockCmd(RCC_AHBPeriph_DMA1, ENABLE);
+	DMA_DeInit(DMA1_Channel2);
+	DMA_StructInit(&DMA_InitStructure);
+	DMA_InitStructure.DMA_PeripheralBaseAddr = (uint32_t) &USART1->TDR;
+	DMA_InitStructure.DMA_MemoryBaseAddr = (uint32_t) uart1_send_buf;
+	DMA_InitStructure.DMA_DIR = DMA_DIR_PeripheralDST;
+	DMA_InitStructure.DMA_BufferSize = 1;
+	DMA_InitStructure.DMA_PeripheralInc = DMA_PeripheralInc_Disable;
+	DMA_InitStructure.DMA_MemoryInc = DMA_MemoryInc_Enable;
+	DMA_InitStructure.DMA_PeripheralDataSize = DMA_PeripheralDataSize_Byte;
+	DMA_InitStructure.DMA_MemoryDataSize = DMA_MemoryDataSize_Byte;
+	DMA_InitStructure.DMA_Mode = DMA_Mode_Normal;
+	DMA_InitStructure.DMA_Priority = DMA_Priority_Medium;
+	DMA_InitStructure.DMA_M2M = DMA_M2M_Disable;
+	DMA_Init(DMA1_Channel2, &DMA_InitStructure);
+	DMA_ITConfig(DMA1_Channel2, DMA_IT_TC, ENABLE);
+	USART_DMACmd(USART1, USART_DMAReq_Tx, ENABLE);
+
+	NVIC_InitStructure.NVIC_IRQChannel = DMA1_Channel2_3_IRQn;
+	NVIC_InitStructure.NVIC_IRQChannelPriority = 1;
+	NVIC_InitStructure.NVIC_IRQChannelCmd = ENABLE;
+	NVIC_Init(&NVIC_InitStructure);
+
 	/* Here the USART1 receive interrupt is enabled
 	 * and the interrupt controller is configured
 	 * to jump to the USART1_IRQHandler() function
@@ -105,7 +147,8 @@ void uart2_init(void) {
 
 	/* Enable USART1 IRQ */
 	NVIC_InitStructure.NVIC_IRQChannel = USART1_IRQn;
-	NVIC_InitStructure.NVIC_IRQChannelPriority = 0;
+	// below the host port, a MIDI byte takes longer to parse than a host byte has to wait
+	NVIC_InitStructure.NVIC_IRQChannelPriority = 1;
 	NVIC_InitStructure.NVIC_IRQChannelCmd = ENABLE;
 	NVIC_Init(&NVIC_InitStructure);
 
@@ -126,6 +169,56 @@ void uart1_send(uint8_t c) {
 	USART_SendData(USART1, c);
 }
 
+// send the next run of queued bytes, the DMA can't wrap so it stops at the end of the buffer
+static void uart1_send_next(void) {
+	uint16_t head = uart1_send_buf_head;
+	uint16_t tail = uart1_send_buf_tail;
+	uint16_t len;
+
+	if (head == tail) {
+		uart1_send_dma_len = 0;
+		return;
+	}
+	len = (head > tail) ? (head - tail) : (UART1_SEND_BUFFER_SIZE - tail);
+
+	DMA_Cmd(DMA1_Channel2, DISABLE);
+	DMA1_Channel2->CMAR = (uint32_t) &uart1_send_buf[tail];
+	DMA_SetCurrDataCounter(DMA1_Channel2, len);
+	uart1_send_dma_len = len;
+	DMA_Cmd(DMA1_Channel2, ENABLE);
+}
+
+uint8_t uart1_queue(const uint8_t * bytes, uint16_t len) {
+	uint16_t head = uart1_send_buf_head;
+	uint16_t used = (head + UART1_SEND_BUFFER_SIZE - uart1_send_buf_tail) % UART1_SEND_BUFFER_SIZE;
+	uint16_t i;
+
+	// one slot stays empty so full and empty look different
+	if ((used + len) >= UART1_SEND_BUFFER_SIZE) {
+		uart1_send_dropped++;
+		return 0;
+	}
+	if ((used + len) > uart1_send_peak) uart1_send_peak = used + len;
+
+	for (i = 0; i < len; i++) {
+		uart1_send_buf[head] = bytes[i];
+		head = (head + 1) % UART1_SEND_BUFFER_SIZE;
+	}
+	uart1_send_buf_head = head;
+
+	// the DMA ISR picks up the new bytes if it is running, otherwise start it
+	if (!uart1_send_dma_len) uart1_send_next();
+	return 1;
+}
+
+void DMA1_Channel2_3_IRQHandler(void) {
+	if (DMA_GetITStatus(DMA1_IT_TC2) != RESET) {
+		DMA_ClearITPendingBit(DMA1_IT_TC2);
+		uart1_send_buf_tail = (uart1_send_buf_tail + uart1_send_dma_len) % UART1_SEND_BUFFER_SIZE;
+		uart1_send_next();
+	}
+}
+
 
 int uart2_available(void) {
 	return (int) (UART2_BUFFER_SIZE + uart2_recv_buf_head - uart2_recv_buf_tail)
@@ -152,29 +245,56 @@ int uart2_read(void) {
 	}
 }
 
-void USART2_IRQHandler(void) {
+// both receive handlers go straight at the registers, they run for every byte.
+// the host one runs from RAM, the MIDI one stays in flash with recvByte
 
-	// check if the USART1 receive interrupt flag was set
+RAMFUNC void USART2_IRQHandler(void) {
+	ISR_CYCLES_BEGIN();
+	uint32_t isr = USART2->ISR;
 
-	if (USART_GetITStatus(USART2, USART_IT_RXNE) != RESET) {
+	if (isr & USART_ISR_RXNE) {
 
-		uart2_recv_buf[uart2_recv_buf_head] = USART_ReceiveData(USART2);
+		uint8_t c = USART2->RDR;
+		uint16_t head = (uart2_recv_buf_head + 1) % UART2_BUFFER_SIZE;
 
-		uart2_recv_buf_head++;
-		uart2_recv_buf_head %= UART2_BUFFER_SIZE;  //
+		// one slot stays empty so full and empty look different, with the
+		// ring full the new byte is dropped rather than the whole ring lost
+		if (head == uart2_recv_buf_tail) {
+			uart2_recv_dropped++;
+		} else {
+			uart2_recv_buf[uart2_recv_buf_head] = c;
+			if (c == 0xC0) uart2_eot_micros = TIM2->CNT;
+			uart2_recv_buf_head = head;
 
+			uint16_t used = (UART2_BUFFER_SIZE + head - uart2_recv_buf_tail) % UART2_BUFFER_SIZE;
+			if (used > uart2_recv_peak) uart2_recv_peak = used;
+		}
 	}
+
+	// an overrun (e.g. while a flash erase stalls the CPU) blocks further
+	// RXNE interrupts until it is cleared
+	if (isr & USART_ISR_ORE) {
+		USART2->ICR = USART_ICR_ORECF;
+		uart2_overruns++;
+	}
+	ISR_CYCLES_END(isr_cycles_host);
 }
 
 void USART1_IRQHandler(void) {
+	ISR_CYCLES_BEGIN();
+	uint32_t isr = USART1->ISR;
 
-	// check if the USART1 receive interrupt flag was set
-	if (USART_GetITStatus(USART1, USART_IT_RXNE) != RESET) {
+	if (isr & USART_ISR_RXNE) {
 
-		uart1_recv_buf[uart1_recv_buf_head] = USART_ReceiveData(USART1);
+		// a few cycles per byte, and nothing left to overflow if the main loop is busy
+		recvByte(USART1->RDR & 0xFF);
 
-		uart1_recv_buf_head++;
-		uart1_recv_buf_head %= UART1_BUFFER_SIZE;  //
+	}
 
+	// an overrun (e.g. while a flash erase stalls the CPU) blocks further
+	// RXNE interrupts until it is cleared
+	if (isr & USART_ISR_ORE) {
+		USART1->ICR = USART_ICR_ORECF;
 	}
+	ISR_CYCLES_END(isr_cycles_midi);
 }
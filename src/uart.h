@@ -9,13 +9,18 @@
 #define UART_H_
 
 #define UART2_BUFFER_SIZE 256
-#define UART1_BUFFER_SIZE 256
+#define UART1_SEND_BUFFER_SIZE 256
 
 #include "stm32f0xx.h"
 
 void uart2_init(void);
 void uart2_send(uint8_t c);
 void uart1_send(uint8_t c);
+
+// MIDI out goes through a queue sent by DMA, all of it is queued or none
+// (returns 0 if it doesn't fit).  not reentrant, callers keep the USART1
+// ISR out while queuing from the main loop
+uint8_t uart1_queue(const uint8_t * bytes, uint16_t len);
 int uart2_available(void);
 int uart2_peek(void);
 int uart2_read(void);
@@ -13,8 +13,19 @@
 caddr_t
 _sbrk(int incr);
 
+char*
+_sbrk_peak(void);
+
+unsigned int
+_sbrk_failures(void);
+
 // ----------------------------------------------------------------------------
 
+// Highest break so far and the requests that didn't fit, for the
+// memory stats (memstats.c).
+static char* peak_heap_end;
+static unsigned int heap_failures;
+
 // The definitions used here should be kept in sync with the
 // stack definitions in the linker script.
 
@@ -49,15 +60,34 @@ _sbrk(int incr)
       abort ();
 #else
       // Heap has overflowed
+      heap_failures++;
       errno = ENOMEM;
       return (caddr_t) -1;
 #endif
     }
 
   current_heap_end += incr;
+  if (current_heap_end > peak_heap_end)
+    peak_heap_end = current_heap_end;
 
   return (caddr_t) current_block_address;
 }
 
+char*
+_sbrk_peak(void)
+{
+  extern char _Heap_Begin; // Defined by the linker.
+
+  if (peak_heap_end == 0)
+    return &_Heap_Begin;
+  return peak_heap_end;
+}
+
+unsigned int
+_sbrk_failures(void)
+{
+  return heap_failures;
+}
+
 // ----------------------------------------------------------------------------
 
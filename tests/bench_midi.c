@@ -0,0 +1,90 @@
+/*
+ * bench_midi.c
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+// parser throughput on a dense stream: a mix of running status notes, CC sweeps,
+// pitch bend, pressure and clock, the way a busy sequencer sends it.  host numbers
+// only say how the parser's cost moves, the per byte cycles on the part are in /stats/isr
+
+#include <stdlib.h>
+#include <time.h>
+#include "host.h"
+#include "midi.h"
+
+extern uint8_t midi_mode;
+
+#define STREAM_BYTES (4 * 1024 * 1024)
+#define PASSES 8
+
+static uint8_t stream[STREAM_BYTES + 8];
+
+static int build(void) {
+	int n = 0;
+	uint8_t status = 0;
+	uint32_t seed = 12345;
+
+	while (n < STREAM_BYTES) {
+		uint8_t ch, kind;
+
+		seed = seed * 1103515245 + 12345;
+		ch = (seed >> 8) & 0x3;
+		kind = (seed >> 12) & 0xF;
+
+		if (kind == 0) {
+			stream[n++] = 0xF8;
+			continue;
+		}
+		if (kind < 7) {            // notes, mostly on running status
+			uint8_t s = 0x90 | ch;
+			if (s != status) stream[n++] = status = s;
+			stream[n++] = (seed >> 16) & 0x7F;
+			stream[n++] = (seed >> 24) & 0x7F;
+		} else if (kind < 12) {    // CC sweeps
+			uint8_t s = 0xB0 | ch;
+			if (s != status) stream[n++] = status = s;
+			stream[n++] = 21 + ((seed >> 16) & 0x7);
+			stream[n++] = (seed >> 24) & 0x7F;
+		} else if (kind < 14) {    // pitch bend
+			uint8_t s = 0xE0 | ch;
+			if (s != status) stream[n++] = status = s;
+			stream[n++] = (seed >> 16) & 0x7F;
+			stream[n++] = (seed >> 24) & 0x7F;
+		} else {                   // channel pressure, one data byte
+			uint8_t s = 0xD0 | ch;
+			if (s != status) stream[n++] = status = s;
+			stream[n++] = (seed >> 16) & 0x7F;
+		}
+	}
+	return n;
+}
+
+static double now(void) {
+	struct timespec t;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return t.tv_sec + (t.tv_nsec * 1e-9);
+}
+
+int main(void) {
+	int n = build();
+	int i, pass;
+	double start, elapsed;
+
+	midi_init(0);
+	midi_mode = MIDI_MODE_SNAPSHOT | MIDI_MODE_EVENTS | MIDI_MODE_CC | MIDI_MODE_STATE | MIDI_MODE_CLOCK;
+
+	start = now();
+	for (pass = 0; pass < PASSES; pass++) {
+		for (i = 0; i < n; i++) {
+			recvByte(stream[i]);
+			// the frame goes out now and then, as it would every 33 ms
+			if ((i & 0xFFF) == 0) midi_frame_swap();
+		}
+	}
+	elapsed = now() - start;
+
+	printf("bench_midi: %d bytes x %d, %.2f ns / byte, %.1f MB/s (MIDI wire rate is 3125 bytes/s)\n",
+			n, PASSES, (elapsed * 1e9) / ((double) n * PASSES), ((double) n * PASSES) / elapsed / 1e6);
+	return 0;
+}
@@ -0,0 +1,59 @@
+/*
+ * bench_ssd1306.c
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+// a full screen of text through the old per pixel path and through put_column,
+// 8 rows of small text and 4 of arial16.  two texts take turns so every pass
+// really changes the pixels.  test_ssd1306 checks the two come out the same
+
+#include <time.h>
+#include "host.h"
+#include "ssd1306.c"
+#include "ssd1306_old.h"
+
+#define PASSES 20000
+
+static char text[2][32] = { "The quick brown fox jumps", "over the lazy dog 0123456" };
+
+static double now(void) {
+	struct timespec t;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return t.tv_sec + (t.tv_nsec * 1e-9);
+}
+
+static double screen_small(void (*println)(char *, int, int, int)) {
+	double start = now();
+	int pass, y;
+
+	for (pass = 0; pass < PASSES; pass++) {
+		for (y = 0; y < 8; y++) println(text[pass & 1], 22, 0, y * 8);
+	}
+	return (now() - start) * 1e6 / PASSES;
+}
+
+static double screen_arial(void (*println)(char *, int, int, int)) {
+	double start = now();
+	int pass, y;
+
+	for (pass = 0; pass < PASSES; pass++) {
+		for (y = 0; y < 4; y++) println(text[pass & 1], 12, 0, y * 16);
+	}
+	return (now() - start) * 1e6 / PASSES;
+}
+
+int main(void) {
+	double old_us, new_us;
+
+	old_us = screen_small(old_println_8);
+	new_us = screen_small(println_8);
+	printf("bench_ssd1306: small text screen, per pixel %.2f us, put_column %.2f us (%.1fx)\n",
+			old_us, new_us, old_us / new_us);
+
+	old_us = screen_arial(old_println_16);
+	new_us = screen_arial(println_16);
+	printf("bench_ssd1306: arial16 screen, per pixel %.2f us, put_column %.2f us (%.1fx)\n",
+			old_us, new_us, old_us / new_us);
+	return 0;
+}
@@ -0,0 +1,48 @@
+/*
+ * host.c
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+// what the firmware's hardware layer provides, for the host builds
+
+#include <string.h>
+#include "host.h"
+
+int host_irq_disabled = 0;
+uint32_t host_nvic_disabled = 0;
+uint32_t host_ipsr = 0;
+DMA_Channel_TypeDef host_dma_channel3;
+
+volatile uint32_t timer_ticks = 0;
+uint32_t host_micros = 0;
+
+uint8_t host_uart1_out[HOST_UART1_OUT_MAX];
+uint16_t host_uart1_out_len = 0;
+
+uint32_t timer_micros(void) {
+	return host_micros;
+}
+
+void timer_sleep(uint32_t ticks) {
+	timer_ticks += ticks;
+}
+
+void spi_init(void) {
+}
+
+// MIDI out, what would have gone to the DMA queue
+uint8_t uart1_queue(const uint8_t * bytes, uint16_t len) {
+	if ((host_uart1_out_len + len) > HOST_UART1_OUT_MAX) return 0;
+	memcpy(&host_uart1_out[host_uart1_out_len], bytes, len);
+	host_uart1_out_len += len;
+	return 1;
+}
+
+int check_failures = 0;
+
+int check_report(const char * name) {
+	if (check_failures) printf("%s: %d failed\n", name, check_failures);
+	else printf("%s: ok\n", name);
+	return check_failures ? 1 : 0;
+}
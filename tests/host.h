@@ -0,0 +1,42 @@
+/*
+ * host.h
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#ifndef HOST_H_
+#define HOST_H_
+
+#include <stdio.h>
+#include <stdint.h>
+#include "stm32f0xx.h"
+
+// the host side of the tests, see host.c
+
+extern volatile uint32_t timer_ticks;
+extern uint32_t host_micros;      // what timer_micros() returns
+
+#define HOST_UART1_OUT_MAX 4096
+extern uint8_t host_uart1_out[];
+extern uint16_t host_uart1_out_len;
+
+// a failed check prints where and carries on, main() returns the count
+extern int check_failures;
+#define CHECK(c) do { \
+		if (!(c)) { \
+			printf("%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #c); \
+			check_failures++; \
+		} \
+	} while (0)
+
+#define CHECK_EQ(a, b) do { \
+		long long check_a = (long long) (a), check_b = (long long) (b); \
+		if (check_a != check_b) { \
+			printf("%s:%d: %s is %lld, expected %lld\n", __FILE__, __LINE__, #a, check_a, check_b); \
+			check_failures++; \
+		} \
+	} while (0)
+
+int check_report(const char * name);
+
+#endif /* HOST_H_ */
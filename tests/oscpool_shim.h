@@ -0,0 +1,26 @@
+/*
+ * oscpool_shim.h
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+// forced in front of the OSC library for the pool replay.  the data arrays are
+// pointers, 8 bytes here and 4 on the part, so realloc passes the element size
+// along and the replay can count the array at the size it has on the part
+
+#ifndef OSCPOOL_SHIM_H_
+#define OSCPOOL_SHIM_H_
+
+#include "OSCPool.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+void * osc_pool_realloc_sized(void * p, size_t size, size_t element);
+#ifdef __cplusplus
+}
+#endif
+
+#define osc_pool_realloc(p, size) osc_pool_realloc_sized((p), (size), sizeof(*(p)))
+
+#endif /* OSCPOOL_SHIM_H_ */
@@ -0,0 +1,291 @@
+/*
+ * replay_oscpool.cpp
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+// the OSC traffic the firmware handles, through the real OSC library, counting
+// what the pools would hold: every message the host can send at its largest,
+// with the reply its handler builds while it is still decoded, and everything
+// the main loop sends at its largest.  the classes are the ones in OSCPool.h
+// with no limit on the count, so the peaks are what each class needs.  sizes are
+// as on the part (OSCData is 24 bytes on both, the data arrays are scaled by the shim)
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "OSCMessage.h"
+#include "SimpleWriter.h"
+
+extern "C" {
+#include "host.h"
+}
+
+// from main.cpp and friends, keep these in step
+#define MAX_MSG_SIZE 224             // SLIPEncodedSerial.h
+#define MIDI_OUT_MAX 128
+#define OLED_TEXT_MAX 32
+#define OLED_BLOB_MAX 200
+#define SCHED_MSG_MAX 32             // sched.h
+#define CURVE_POINTS 33              // curves.h
+#define MIDI_EVENT_BYTES (32 * 5)    // MIDI_EVENT_MAX * MIDI_EVENT_SIZE
+#define MIDI_CC_PAIRS_MAX 64
+#define MIDI_STATE_RECORDS_MAX 64
+#define SYSEX_MAX 120                // sysex.h
+#define LOOP_ENTRIES 11              // LOOP_STAGES + the whole pass
+#define LAT_PROBES 6
+#define LAT_BUCKETS 12
+
+static const uint16_t class_size[OSC_POOL_CLASSES] = { OSC_POOL_SMALL_SIZE, OSC_POOL_MEDIUM_SIZE, OSC_POOL_LARGE_SIZE };
+static const uint16_t class_count[OSC_POOL_CLASSES] = { OSC_POOL_SMALL_COUNT, OSC_POOL_MEDIUM_COUNT, OSC_POOL_LARGE_COUNT };
+
+#define MALLOC_CLASS OSC_POOL_CLASSES
+
+static int counting = 0;
+static int live[OSC_POOL_CLASSES + 1];
+static int peak[OSC_POOL_CLASSES + 1];
+static int run_peak[OSC_POOL_CLASSES + 1];
+static size_t biggest[OSC_POOL_CLASSES + 1];   // largest request each class got
+
+// every block carries the class it would be in on the part
+typedef struct {
+	size_t size;
+	int pool;
+	int counted;
+} block_t;
+
+#define HEADER 16
+
+static block_t * block_of(void * p) {
+	return (block_t *) ((uint8_t *) p - HEADER);
+}
+
+static int class_for(size_t size) {
+	int i;
+	for (i = 0; i < OSC_POOL_CLASSES; i++) if (size <= class_size[i]) return i;
+	return MALLOC_CLASS;
+}
+
+static void take(block_t * b, int pool, size_t size) {
+	b->pool = pool;
+	b->size = size;
+	b->counted = counting;
+	if (!counting) return;
+	live[pool]++;
+	if (live[pool] > peak[pool]) peak[pool] = live[pool];
+	if (live[pool] > run_peak[pool]) run_peak[pool] = live[pool];
+	if (size > biggest[pool]) biggest[pool] = size;
+}
+
+static void give(block_t * b) {
+	if (b->counted) live[b->pool]--;
+}
+
+extern "C" void * osc_pool_alloc(size_t size) {
+	block_t * b = (block_t *) malloc(HEADER + size);
+	if (!b) return 0;
+	take(b, class_for(size), size);
+	return (uint8_t *) b + HEADER;
+}
+
+extern "C" void osc_pool_free(void * p) {
+	if (!p) return;
+	give(block_of(p));
+	free(block_of(p));
+}
+
+// the same moves as OSCPool.c: stay put while it fits, drop a class if it
+// fits the one below, otherwise go up.  malloc blocks stay with malloc
+extern "C" void * osc_pool_realloc_sized(void * p, size_t size, size_t element) {
+	size_t part_size = (element == sizeof(void *)) ? (size / sizeof(void *)) * 4 : size;
+	block_t * b;
+	int pool;
+
+	if (!p) {
+		b = (block_t *) malloc(HEADER + size);
+		if (!b) return 0;
+		take(b, class_for(part_size), part_size);
+		return (uint8_t *) b + HEADER;
+	}
+	b = block_of(p);
+	pool = b->pool;
+	if ((pool != MALLOC_CLASS) && (part_size <= class_size[pool])) {
+		if ((pool > 0) && (part_size <= class_size[pool - 1])) pool--;
+	} else if (pool != MALLOC_CLASS) {
+		pool = class_for(part_size);
+	}
+	give(b);
+	b = (block_t *) realloc(b, HEADER + size);
+	if (!b) return 0;
+	take(b, pool, part_size);
+	return (uint8_t *) b + HEADER;
+}
+
+static SimpleWriter wire;
+static uint8_t blob[256];
+
+// what the host sends, encoded without counting
+static int encode(OSCMessage & msg, uint8_t * out) {
+	wire.start();
+	msg.send(wire);
+	memcpy(out, wire.buffer, wire.length);
+	return wire.length;
+}
+
+static void send(OSCMessage & msg) {
+	msg.send(wire);
+	msg.empty();
+}
+
+static OSCMessage * msgIn;
+
+// a message from the host comes in and is handled, reply (if any) built while it is decoded
+static void incoming(const char * name, OSCMessage & host, void (*reply)(void)) {
+	uint8_t bytes[MAX_MSG_SIZE + 64];
+	int len, i;
+
+	counting = 0;
+	len = encode(host, bytes);
+	host.empty();
+	counting = 1;
+
+	if (len > MAX_MSG_SIZE) {
+		printf("%s: %d bytes doesn't fit the SLIP buffer\n", name, len);
+		check_failures++;
+	}
+	memset(run_peak, 0, sizeof(run_peak));
+	for (i = 0; i < len; i++) msgIn->fill(bytes[i]);
+	CHECK(!msgIn->hasError());
+	if (reply) reply();
+	msgIn->empty();
+	printf("  %-24s %3d bytes   %2d %2d %2d %2d\n", name, len, run_peak[0], run_peak[1], run_peak[2], run_peak[3]);
+}
+
+static void outgoing(const char * name, OSCMessage & msg) {
+	// run_peak was cleared before the message was made, its address counts
+	send(msg);
+	printf("  %-24s             %2d %2d %2d %2d\n", name, run_peak[0], run_peak[1], run_peak[2], run_peak[3]);
+}
+
+static void ints(OSCMessage & msg, int n) {
+	int i;
+	for (i = 0; i < n; i++) msg.add((int32_t) i);
+}
+
+static void reply_ints(const char * address, int n) {
+	OSCMessage msg(address);
+	ints(msg, n);
+	send(msg);
+}
+
+static void reply_sync(void) {
+	OSCMessage msg("/sync");
+	osctime_t t = { 1, 2 };
+	msg.add((int32_t) 1);
+	msg.add(t);
+	msg.add(t);
+	send(msg);
+}
+
+static void reply_stats(void) { reply_ints("/stats", 14); }
+static void reply_pool(void) { reply_ints("/stats/pool", (OSC_POOL_CLASSES * 4) + 2); }
+static void reply_frame(void) { reply_ints("/stats/frame", 7); }
+static void reply_sched(void) { reply_ints("/stats/sched", 7); }
+static void reply_isr(void) { reply_ints("/stats/isr", 6); }
+static void reply_latency_all(void) { reply_ints("/stats/latency", LAT_PROBES * 3); }
+static void reply_latency_one(void) { reply_ints("/stats/latency", 4 + LAT_BUCKETS); }
+static void reply_loop(void) { reply_ints("/stats/loop", 1 + (LOOP_ENTRIES * 3)); }
+static void reply_oled(void) { reply_ints("/oled/stats", 5); }
+
+// what /at queued runs at the top of the loop, in its own OSCMessage (msgIn is empty then)
+static void scheduled(const char * name, OSCMessage & inner, void (*reply)(void)) {
+	uint8_t bytes[64];
+	int len, i;
+
+	counting = 0;
+	len = encode(inner, bytes);
+	inner.empty();
+	counting = 1;
+
+	if (len > SCHED_MSG_MAX) {
+		printf("%s: %d bytes doesn't fit an /at slot\n", name, len);
+		check_failures++;
+	}
+	memset(run_peak, 0, sizeof(run_peak));
+	{
+		OSCMessage msgAt;
+		for (i = 0; i < len; i++) msgAt.fill(bytes[i]);
+		CHECK(!msgAt.hasError());
+		if (reply) reply();
+		msgAt.empty();
+	}
+	printf("  %-24s %3d bytes   %2d %2d %2d %2d\n", name, len, run_peak[0], run_peak[1], run_peak[2], run_peak[3]);
+}
+
+int main(void) {
+	osctime_t t = { 1, 2 };
+	char text[OLED_TEXT_MAX + 1];
+	int i;
+
+	memset(blob, 0x55, sizeof(blob));
+	memset(text, 'x', OLED_TEXT_MAX);
+	text[OLED_TEXT_MAX] = 0;
+
+	counting = 1;
+	msgIn = new OSCMessage();
+
+	printf("replay_oscpool: peak blocks        small medium large malloc\n");
+
+	// host to controller, at the largest each handler takes
+	{ counting = 0; OSCMessage m("/nf"); incoming("/nf", m, 0); }
+	{ counting = 0; OSCMessage m("/led"); ints(m, 1); incoming("/led", m, 0); }
+	{ counting = 0; OSCMessage m("/midichmask"); ints(m, 1); incoming("/midichmask", m, 0); }
+	{ counting = 0; OSCMessage m("/replylead"); ints(m, 1); incoming("/replylead", m, 0); }
+	{ counting = 0; OSCMessage m("/curve"); ints(m, 2); incoming("/curve", m, 0); }
+	{ counting = 0; OSCMessage m("/curvetable"); ints(m, 1 + CURVE_POINTS); incoming("/curvetable", m, 0); }
+	{ counting = 0; OSCMessage m("/midiout"); m.add(blob, MIDI_OUT_MAX); incoming("/midiout", m, 0); }
+	{ counting = 0; OSCMessage m("/sync"); ints(m, 1); incoming("/sync", m, reply_sync); }
+	{ counting = 0; OSCMessage m("/sync/set"); m.add(t); m.add(t); ints(m, 1); incoming("/sync/set", m, 0); }
+	{ counting = 0; OSCMessage m("/at"); m.add(t); m.add(blob, SCHED_MSG_MAX); incoming("/at", m, 0); }
+	{ counting = 0; OSCMessage m("/stats"); incoming("/stats", m, reply_stats); }
+	{ counting = 0; OSCMessage m("/stats/pool"); incoming("/stats/pool", m, reply_pool); }
+	{ counting = 0; OSCMessage m("/stats/frame"); incoming("/stats/frame", m, reply_frame); }
+	{ counting = 0; OSCMessage m("/stats/sched"); incoming("/stats/sched", m, reply_sched); }
+	{ counting = 0; OSCMessage m("/stats/isr"); incoming("/stats/isr (DEBUG)", m, reply_isr); }
+	{ counting = 0; OSCMessage m("/stats/latency"); incoming("/stats/latency (DEBUG)", m, reply_latency_all); }
+	{ counting = 0; OSCMessage m("/stats/latency"); ints(m, 1); incoming("/stats/latency n (DEBUG)", m, reply_latency_one); }
+	{ counting = 0; OSCMessage m("/stats/loop"); incoming("/stats/loop (DEBUG)", m, reply_loop); }
+	{ counting = 0; OSCMessage m("/oled/fill"); ints(m, 5); incoming("/oled/fill", m, 0); }
+	{ counting = 0; OSCMessage m("/oled/text"); ints(m, 2); m.add(text); ints(m, 1); incoming("/oled/text", m, 0); }
+	{ counting = 0; OSCMessage m("/oled/rle"); ints(m, 1); m.add(blob, OLED_BLOB_MAX); incoming("/oled/rle", m, 0); }
+	{ counting = 0; OSCMessage m("/oled/stats"); incoming("/oled/stats", m, reply_oled); }
+
+	// the largest replies again, run from /at
+	{ counting = 0; OSCMessage m("/curve"); ints(m, 2); scheduled("/at: /curve", m, 0); }
+	{ counting = 0; OSCMessage m("/stats"); scheduled("/at: /stats", m, reply_stats); }
+	{ counting = 0; OSCMessage m("/stats/loop"); scheduled("/at: /stats/loop (DEBUG)", m, reply_loop); }
+
+	// controller to host from the main loop, msgIn is empty then
+	{ counting = 1; memset(run_peak, 0, sizeof(run_peak)); OSCMessage m("/mblob"); m.add(blob, 23); outgoing("/mblob", m); }
+	{ counting = 1; memset(run_peak, 0, sizeof(run_peak)); OSCMessage m("/mev"); ints(m, 1); m.add(blob, MIDI_EVENT_BYTES); outgoing("/mev", m); }
+	{ counting = 1; memset(run_peak, 0, sizeof(run_peak)); OSCMessage m("/mcc"); m.add(blob, MIDI_CC_PAIRS_MAX * 2); outgoing("/mcc", m); }
+	{ counting = 1; memset(run_peak, 0, sizeof(run_peak)); OSCMessage m("/mst"); m.add(blob, MIDI_STATE_RECORDS_MAX * 3); outgoing("/mst", m); }
+	{ counting = 1; memset(run_peak, 0, sizeof(run_peak)); OSCMessage m("/clk"); ints(m, 4); outgoing("/clk", m); }
+	{ counting = 1; memset(run_peak, 0, sizeof(run_peak)); OSCMessage m("/sysex"); ints(m, 2); m.add(blob, SYSEX_MAX); outgoing("/sysex", m); }
+	{ counting = 1; memset(run_peak, 0, sizeof(run_peak)); OSCMessage m("/knobs"); ints(m, 6); outgoing("/knobs", m); }
+	{ counting = 1; memset(run_peak, 0, sizeof(run_peak)); OSCMessage m("/kt"); ints(m, 11); outgoing("/kt", m); }
+	{ counting = 1; memset(run_peak, 0, sizeof(run_peak)); OSCMessage m("/key"); ints(m, 2); outgoing("/key", m); }
+	{ counting = 1; memset(run_peak, 0, sizeof(run_peak)); OSCMessage m("/save"); outgoing("/save", m); }
+
+	printf("  %-24s             %2d %2d %2d %2d\n", "peak", peak[0], peak[1], peak[2], peak[3]);
+	printf("  %-24s             %2d %2d %2d\n", "pool count", class_count[0], class_count[1], class_count[2]);
+	printf("  %-24s            %3d %3d %3d\n", "largest request", (int) biggest[0], (int) biggest[1], (int) biggest[2]);
+
+	// everything the firmware sends and takes has to fit without going to malloc
+	for (i = 0; i < OSC_POOL_CLASSES; i++) CHECK(peak[i] <= class_count[i]);
+	CHECK_EQ(peak[MALLOC_CLASS], 0);
+
+	delete msgIn;
+	for (i = 0; i <= OSC_POOL_CLASSES; i++) CHECK_EQ(live[i], 0);
+	return check_report("replay_oscpool");
+}
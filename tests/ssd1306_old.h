@@ -0,0 +1,68 @@
+/*
+ * ssd1306_old.h
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+// text drawing as it was before put_column, a put_pixel() per pixel.  kept as
+// the reference the column path has to match, include after ssd1306.c
+
+static uint8_t old_put_char_small(unsigned char c, uint8_t y, uint8_t x) {
+	uint8_t i, j;
+	for (i = 0; i < 5; i++) {
+		for (j = 0; j < 8; j++) {
+			if ((font[(c * 5) + i] >> j) & 0x01)
+				put_pixel(1, y + i, x + j);
+			else
+				put_pixel(0, y + i, x + j);
+		}
+	}
+	return 5;
+}
+
+static unsigned int old_put_char_arial16(unsigned char character, unsigned int y,
+		unsigned int x, unsigned int color) {
+	int i;
+	int j;
+	int k;
+	int charWidth;
+	int charOffset;
+
+	if (character == 32)
+		return 4;
+
+	character -= 33;
+
+	charWidth = arial16Width[character + 1];
+	charOffset = arial16Offset[character] * 2;
+
+	for (i = 0; i < 2; i++) {
+		for (j = 0; j < 8; j++) {
+			for (k = 0; k < charWidth; k++) {
+				if ((arial16[charOffset + k + (i * charWidth)] >> j) & 0x01)
+					put_pixel(color, (y + k), (x + (i * 8) + j));
+				else
+					put_pixel(0, (y + k), (x + (i * 8) + j));
+			}
+		}
+	}
+	return charWidth + 1;
+}
+
+static void old_println_16(char * line, int len, int x, int y) {
+	int i, deltax;
+	deltax = x;
+	for (i = 0; i < len; i++) {
+		deltax += old_put_char_arial16(line[i], deltax, y, 1);
+		deltax += 2;
+	}
+}
+
+static void old_println_8(char * line, int len, int x, int y) {
+	int i, deltax;
+	deltax = x;
+	for (i = 0; i < len; i++) {
+		deltax += old_put_char_small(line[i], deltax, y);
+		deltax += 1;
+	}
+}
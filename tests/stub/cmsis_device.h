@@ -0,0 +1,12 @@
+/*
+ * cmsis_device.h
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#ifndef CMSIS_DEVICE_H_
+#define CMSIS_DEVICE_H_
+
+#include "stm32f0xx.h"
+
+#endif /* CMSIS_DEVICE_H_ */
@@ -0,0 +1,61 @@
+/*
+ * stm32f0xx.h
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#ifndef STM32F0XX_H_
+#define STM32F0XX_H_
+
+// stands in for the device header in the host builds, just enough for the
+// sources under test to compile.  interrupt masking is counted so the tests
+// can see it happened, the peripherals do nothing
+
+#include <stdint.h>
+
+#define __IO volatile
+
+typedef enum { RESET = 0, SET = !RESET } FlagStatus;
+typedef enum { DISABLE = 0, ENABLE = !DISABLE } FunctionalState;
+
+typedef enum { USART1_IRQn = 27, USART2_IRQn = 28 } IRQn_Type;
+
+extern int host_irq_disabled;          // __disable_irq() nesting
+extern uint32_t host_nvic_disabled;    // bit per IRQn held off by NVIC_DisableIRQ()
+extern uint32_t host_ipsr;             // nonzero to look like handler mode
+
+static inline void __disable_irq(void) { host_irq_disabled++; }
+static inline void __enable_irq(void) { host_irq_disabled--; }
+static inline uint32_t __get_IPSR(void) { return host_ipsr; }
+static inline void NVIC_DisableIRQ(IRQn_Type irq) { host_nvic_disabled |= (1UL << irq); }
+static inline void NVIC_EnableIRQ(IRQn_Type irq) { host_nvic_disabled &= ~(1UL << irq); }
+
+// OLED pins, SPI and DMA
+#define GPIOA 0
+#define GPIO_Pin_5 0x0020
+#define GPIO_Pin_7 0x0080
+#define GPIO_Pin_8 0x0100
+#define GPIO_Pin_9 0x0200
+#define GPIO_Pin_10 0x0400
+#define GPIO_SetBits(port, pin) ((void) 0)
+#define GPIO_ResetBits(port, pin) ((void) 0)
+
+#define SPI1 0
+#define SPI_I2S_FLAG_TXE 0x0002
+#define SPI_I2S_FLAG_BSY 0x0080
+#define SPI_I2S_GetFlagStatus(spi, flag) (((flag) == SPI_I2S_FLAG_TXE) ? SET : RESET)
+#define SPI_SendData8(spi, byte) ((void) 0)
+
+typedef struct {
+	uintptr_t CMAR;
+} DMA_Channel_TypeDef;
+extern DMA_Channel_TypeDef host_dma_channel3;
+#define DMA1_Channel3 (&host_dma_channel3)
+#define DMA1_FLAG_GL3 0x00000100
+#define DMA1_FLAG_TC3 0x00000200
+#define DMA_Cmd(channel, state) ((void) 0)
+#define DMA_ClearFlag(flag) ((void) 0)
+#define DMA_SetCurrDataCounter(channel, n) ((void) 0)
+#define DMA_GetFlagStatus(flag) SET
+
+#endif /* STM32F0XX_H_ */
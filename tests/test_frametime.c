@@ -0,0 +1,174 @@
+/*
+ * test_frametime.c
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+// frame reply timing: learning the /nf interval, the fixed delay until it is
+// known and again after a pause, and late frames against slack
+
+#include "host.h"
+#include "frametime.h"
+
+static uint32_t now = 1000000;
+static frametime_stats_t st;
+
+// a frame /interval/ after the last one, replied /reply/ us after it (0 doesn't)
+static void frame(uint32_t interval, uint32_t reply) {
+	now += interval;
+	frametime_nf(now);
+	if (reply) frametime_replied(now + reply);
+}
+
+// a frame where the reply goes the moment it is due, which has to be /delay/
+static void frame_due(uint32_t interval, uint32_t delay) {
+	now += interval;
+	frametime_nf(now);
+	CHECK(!frametime_reply_due(now + delay - 1));
+	CHECK(frametime_reply_due(now + delay));
+	frametime_replied(now + delay);
+	CHECK(!frametime_reply_due(now + delay + 1));
+}
+
+static void test_learning(void) {
+	int i;
+
+	// the first /nf has no interval, the next three aren't enough to go on
+	frame_due(0, FRAMETIME_DEFAULT_DELAY);
+	for (i = 0; i < FRAMETIME_LEARN_FRAMES - 1; i++) {
+		frame_due(40000, FRAMETIME_DEFAULT_DELAY);
+		frametime_stats(&st);
+		CHECK_EQ(st.delay, FRAMETIME_DEFAULT_DELAY);
+	}
+
+	// learned, the reply goes 25% of 40 ms ahead of the next one
+	frame_due(40000, 30000);
+	frametime_stats(&st);
+	CHECK_EQ(st.interval, 40000);
+	CHECK_EQ(st.jitter, 0);
+	CHECK_EQ(st.delay, 30000);
+	CHECK_EQ(st.frames, FRAMETIME_LEARN_FRAMES + 1);
+
+	// it follows a change of rate
+	for (i = 0; i < 200; i++) frame(50000, 0), frametime_replied(now + 1000);
+	frametime_stats(&st);
+	CHECK(st.interval >= 49990 && st.interval <= 50000);
+	CHECK(st.delay >= 37490 && st.delay <= 37500);
+
+	// jitter is the average distance from the interval
+	for (i = 0; i < 200; i++) {
+		frame((i & 1) ? 49000 : 51000, 0);
+		frametime_replied(now + 1000);
+	}
+	frametime_stats(&st);
+	CHECK(st.interval >= 49800 && st.interval <= 50200);
+	CHECK(st.jitter >= 800 && st.jitter <= 1100);
+
+	for (i = 0; i < 200; i++) frame(40000, 0), frametime_replied(now + 1000);
+}
+
+static void test_lead(void) {
+	frametime_set_lead(50);
+	frametime_stats(&st);
+	CHECK_EQ(st.delay, 20000);
+
+	// clamped to the max
+	frametime_set_lead(200);
+	frametime_stats(&st);
+	CHECK_EQ(st.delay, 40000 - (40000 * FRAMETIME_LEAD_MAX) / 100);
+
+	frametime_set_lead(FRAMETIME_LEAD_DEFAULT);
+	frametime_stats(&st);
+	CHECK_EQ(st.delay, 30000);
+}
+
+static void test_late_slack(void) {
+	uint32_t late;
+	int i;
+
+	for (i = 0; i < 200; i++) frame(40000, 30000);
+	frametime_stats(&st);
+	late = st.late;
+	CHECK_EQ(st.slack, 10000);
+	CHECK_EQ(st.slack_min, 10000);
+
+	// no reply before the next /nf is late and leaves slack alone
+	frame(40000, 0);
+	frame(40000, 30000);
+	frametime_stats(&st);
+	CHECK_EQ(st.late, late + 1);
+	CHECK_EQ(st.slack, 10000);
+
+	// a close one shows in the min, which starts over once read
+	frame(40000, 39000);
+	frame(40000, 30000);
+	frametime_stats(&st);
+	CHECK_EQ(st.late, late + 1);
+	CHECK_EQ(st.slack_min, 1000);
+	CHECK(st.slack < 10000);
+	frame(40000, 30000);
+	frametime_stats(&st);
+	CHECK_EQ(st.slack_min, 10000);
+
+	// nothing since the last read
+	frametime_stats(&st);
+	CHECK_EQ(st.slack_min, 0);
+}
+
+static void test_pause(void) {
+	int32_t slack;
+	uint32_t late;
+	int i;
+
+	for (i = 0; i < 200; i++) frame(40000, 30000);
+	frametime_stats(&st);
+	slack = st.slack;
+	late = st.late;
+
+	// a pause starts the learning over, and the gap isn't counted as slack
+	frame_due(FRAMETIME_MAX_INTERVAL + 1, FRAMETIME_DEFAULT_DELAY);
+	frametime_stats(&st);
+	CHECK_EQ(st.slack, slack);
+	CHECK_EQ(st.slack_min, 0);
+	for (i = 0; i < FRAMETIME_LEARN_FRAMES - 1; i++) frame_due(33000, FRAMETIME_DEFAULT_DELAY);
+	frame_due(33000, 24750);
+	frametime_stats(&st);
+	CHECK_EQ(st.interval, 33000);
+	CHECK_EQ(st.delay, 24750);
+
+	// not replying before a pause isn't late either
+	frame(33000, 0);
+	frame(FRAMETIME_MAX_INTERVAL + 1, FRAMETIME_DEFAULT_DELAY);
+	frametime_stats(&st);
+	CHECK_EQ(st.late, late);
+
+	// right at the limit is still a frame
+	frame(FRAMETIME_MAX_INTERVAL, FRAMETIME_DEFAULT_DELAY);
+	frame(FRAMETIME_MAX_INTERVAL, FRAMETIME_DEFAULT_DELAY);
+	frametime_stats(&st);
+	CHECK_EQ(st.interval, FRAMETIME_MAX_INTERVAL);
+}
+
+static void test_wrap(void) {
+	int i;
+
+	// timer_micros() wraps every 71 minutes, that far a jump is a pause too
+	now = 0xFFFFFFFF - 100000;
+	frame(0, FRAMETIME_DEFAULT_DELAY);
+	for (i = 0; i < FRAMETIME_LEARN_FRAMES - 1; i++) frame(40000, FRAMETIME_DEFAULT_DELAY);
+	for (i = 0; i < 8; i++) frame_due(40000, 30000);
+	frametime_stats(&st);
+	CHECK(now < 1000000);
+	CHECK_EQ(st.interval, 40000);
+	CHECK_EQ(st.delay, 30000);
+	CHECK_EQ(st.slack_min, 10000);
+}
+
+int main(void) {
+	test_learning();
+	test_lead();
+	test_late_slack();
+	test_pause();
+	test_wrap();
+	return check_report("test_frametime");
+}
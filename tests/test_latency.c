@@ -0,0 +1,82 @@
+/*
+ * test_latency.c
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+// latency_record's buckets: under 16 us, then twice as wide each, the last one
+// open ended.  built with DEBUG, in a release build none of it exists
+
+#include "host.h"
+#include "latency.h"
+
+static latency_probe_t p;
+
+// the bucket /us/ lands in
+static int bucket(uint32_t us) {
+	int b;
+
+	latency_clear();
+	latency_record(LAT_NF_DISPATCH, us);
+	latency_get(LAT_NF_DISPATCH, &p);
+	for (b = 0; b < LAT_BUCKETS; b++) if (p.buckets[b]) return b;
+	return -1;
+}
+
+static void test_edges(void) {
+	uint32_t low;
+	int b;
+
+	CHECK_EQ(bucket(0), 0);
+	CHECK_EQ(bucket(15), 0);
+
+	// bucket b starts at 16 << (b - 1)
+	for (b = 1; b < LAT_BUCKETS; b++) {
+		low = 16u << (b - 1);
+		CHECK_EQ(bucket(low - 1), b - 1);
+		CHECK_EQ(bucket(low), b);
+	}
+
+	// the last one takes the rest
+	CHECK_EQ(bucket(16384), LAT_BUCKETS - 1);
+	CHECK_EQ(bucket(1000000), LAT_BUCKETS - 1);
+	CHECK_EQ(bucket(0xFFFFFFFF), LAT_BUCKETS - 1);
+}
+
+static void test_totals(void) {
+	int i;
+
+	latency_clear();
+	latency_record(LAT_KEY_EVENT, 100);
+	latency_record(LAT_KEY_EVENT, 300);
+	latency_record(LAT_KEY_EVENT, 20);
+	latency_get(LAT_KEY_EVENT, &p);
+	CHECK_EQ(p.count, 3);
+	CHECK_EQ(p.total, 420);
+	CHECK_EQ(p.max, 300);
+	CHECK_EQ(p.buckets[1], 1);
+	CHECK_EQ(p.buckets[3], 1);
+	CHECK_EQ(p.buckets[5], 1);
+
+	// the probes are apart
+	latency_get(LAT_KEY_TX_DONE, &p);
+	CHECK_EQ(p.count, 0);
+
+	// a bucket stops at the top instead of wrapping
+	for (i = 0; i < 70000; i++) latency_record(LAT_NF_REPLY_DONE, 5);
+	latency_get(LAT_NF_REPLY_DONE, &p);
+	CHECK_EQ(p.buckets[0], 0xFFFF);
+	CHECK_EQ(p.count, 70000);
+
+	latency_clear();
+	latency_get(LAT_NF_REPLY_DONE, &p);
+	CHECK_EQ(p.count, 0);
+	CHECK_EQ(p.max, 0);
+	CHECK_EQ(p.buckets[0], 0);
+}
+
+int main(void) {
+	test_edges();
+	test_totals();
+	return check_report("test_latency");
+}
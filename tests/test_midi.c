@@ -0,0 +1,275 @@
+/*
+ * test_midi.c
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+// the MIDI parser against byte streams in midi/, checking what ends up in the
+// frame (snapshot and event list), the CC and state tables, SysEx and soft thru
+
+#include <stdlib.h>
+#include <string.h>
+#include "host.h"
+#include "midi.h"
+#include "sysex.h"
+
+extern uint8_t midi_mode;
+extern uint8_t midi_cc[128];
+extern uint8_t midi_velocity[128];
+extern uint8_t midi_poly_pressure[128];
+extern uint16_t midi_pitch_bend;
+extern uint16_t midi_mod_wheel;
+
+#define STREAM_MAX 1024
+
+// hex bytes, # to the end of the line is a comment
+static int load(const char * name, uint8_t * bytes) {
+	char path[256];
+	char line[256];
+	char * p, * end;
+	FILE * f;
+	int n = 0;
+
+	snprintf(path, sizeof(path), "midi/%s", name);
+	f = fopen(path, "r");
+	if (!f) {
+		printf("can't open %s\n", path);
+		exit(1);
+	}
+	while (fgets(line, sizeof(line), f)) {
+		if ((p = strchr(line, '#'))) *p = 0;
+		p = line;
+		for (;;) {
+			long b = strtol(p, &end, 16);
+			if (end == p) break;
+			if (n < STREAM_MAX) bytes[n++] = b;
+			p = end;
+		}
+	}
+	fclose(f);
+	return n;
+}
+
+static void reset(uint16_t mask, uint8_t thru) {
+	uint8_t * m;
+	uint8_t flags;
+	uint16_t lost;
+
+	midi_init(0);
+	midi_set_channel_mask(mask);
+	midi_mode = MIDI_MODE_SNAPSHOT | MIDI_MODE_EVENTS | MIDI_MODE_CC | MIDI_MODE_STATE | MIDI_MODE_CLOCK;
+	midi_thru = thru;
+	host_uart1_out_len = 0;
+	while (sysex_get(&m, &flags, &lost)) sysex_release();
+}
+
+static void feed(const uint8_t * bytes, int n) {
+	int i;
+	for (i = 0; i < n; i++) recvByte(bytes[i]);
+}
+
+static int event_is(midi_frame_t * f, int i, uint8_t status, uint8_t data1, uint8_t data2) {
+	uint8_t * e = &f->events[i * MIDI_EVENT_SIZE];
+	if (i >= f->event_count) return 0;
+	return (e[2] == status) && (e[3] == data1) && (e[4] == data2);
+}
+
+static int note_on(midi_frame_t * f, uint8_t note) {
+	return (f->blob[note >> 3] >> (note & 7)) & 1;
+}
+
+static void test_running_status(void) {
+	uint8_t s[STREAM_MAX];
+	int n = load("running_status.hex", s);
+	midi_frame_t * f;
+
+	reset(0xFFFF, 0);
+	feed(s, n);
+	f = midi_frame_swap();
+
+	CHECK_EQ(f->event_count, 12);
+	CHECK(event_is(f, 0, 0x90, 0x3C, 0x64));
+	CHECK(event_is(f, 1, 0x90, 0x40, 0x50));
+	CHECK(event_is(f, 2, 0x90, 0x43, 0x7F));
+	CHECK(event_is(f, 3, 0xA0, 0x43, 0x30));
+	CHECK(event_is(f, 4, 0x80, 0x3C, 0x00));    // velocity 0 is listed as an off
+	CHECK(event_is(f, 5, 0x80, 0x40, 0x00));
+	CHECK(event_is(f, 6, 0x80, 0x43, 0x20));
+	CHECK(event_is(f, 7, 0xB0, 0x15, 0x10));
+	CHECK(event_is(f, 8, 0xB0, 0x16, 0x20));
+	CHECK(event_is(f, 9, 0xB0, 0x01, 0x40));
+	CHECK(event_is(f, 10, 0xB0, 0x21, 0x05));
+	CHECK(event_is(f, 11, 0xE0, 0x00, 0x60));
+
+	CHECK(!note_on(f, 0x3C) && !note_on(f, 0x40) && !note_on(f, 0x43));
+	CHECK_EQ(f->blob[16], 0x10);   // knob CCs 21 - 25
+	CHECK_EQ(f->blob[17], 0x20);
+
+	CHECK_EQ(midi_cc[0x15], 0x10);
+	CHECK_EQ(midi_cc[0x16], 0x20);
+	CHECK_EQ(midi_cc[0x01], 0x40);
+	CHECK_EQ(midi_cc[0x21], 0x05);
+	CHECK_EQ(midi_mod_wheel, (0x40 << 7) | 0x05);
+	CHECK_EQ(midi_pitch_bend, 0x60 << 7);
+	CHECK_EQ(midi_velocity[0x43], 0);
+	CHECK_EQ(midi_poly_pressure[0x43], 0);   // went with the note
+
+	// the CC reply has the 4 that changed, lowest first
+	{
+		uint8_t buf[16];
+		CHECK_EQ(midi_cc_collect(buf, 8), 4);
+		CHECK(buf[0] == 0x01 && buf[1] == 0x40 && buf[2] == 0x15 && buf[3] == 0x10);
+		CHECK_EQ(midi_cc_collect(buf, 8), 0);
+	}
+}
+
+static void test_realtime(void) {
+	uint8_t s[STREAM_MAX];
+	int n = load("realtime.hex", s);
+	int i, clocks = 0, thru_clocks = 0;
+	midi_frame_t * f;
+	static const uint8_t thru[] = {
+		0xFA, 0xF8, 0xF8, 0xF8, 0xF8, 0x90, 0x3C, 0x64, 0xF8, 0xFE,
+		0xF8, 0x3C, 0x00,            // running status on the way out too
+		0xF8, 0xF8, 0xB0, 0x15, 0x7F,
+	};
+
+	reset(0x0001, MIDI_THRU_VOICE | MIDI_THRU_REALTIME);
+	feed(s, n);
+	f = midi_frame_swap();
+
+	for (i = 0; i < n; i++) if (s[i] == 0xF8) clocks++;
+	for (i = 0; i < sizeof(thru); i++) if (thru[i] == 0xF8) thru_clocks++;
+
+	CHECK_EQ(f->event_count, 5);
+	CHECK(event_is(f, 0, 0xFA, 0, 0));
+	CHECK(event_is(f, 1, 0x90, 0x3C, 0x64));
+	CHECK(event_is(f, 2, 0x80, 0x3C, 0x00));
+	CHECK(event_is(f, 3, 0xB0, 0x15, 0x7F));
+	CHECK(event_is(f, 4, 0xFC, 0, 0));
+	CHECK_EQ(f->blob[21], clocks % 24);    // sync count, from 0 at start
+	CHECK_EQ(midi_cc[0x15], 0x7F);
+
+	CHECK(host_uart1_out_len >= sizeof(thru));
+	CHECK(!memcmp(host_uart1_out, thru, sizeof(thru)));
+	CHECK_EQ(host_uart1_out_len, sizeof(thru) + (clocks - thru_clocks) + 1);   // the rest of the clocks and the stop
+}
+
+static void test_sysex(void) {
+	uint8_t s[STREAM_MAX];
+	int n = load("sysex.hex", s);
+	int i, got = 0;
+	uint8_t lens[8], flags_seen[8];
+	uint8_t msgs[8][SYSEX_MAX];
+	uint8_t * m, flags, len;
+	uint16_t lost;
+	midi_frame_t * f;
+
+	reset(0xFFFF, 0);
+	// the main loop picks each one up before the next is done
+	for (i = 0; i < n; i++) {
+		recvByte(s[i]);
+		if ((len = sysex_get(&m, &flags, &lost)) && (got < 8)) {
+			lens[got] = len;
+			flags_seen[got] = flags;
+			memcpy(msgs[got], m, len);
+			got++;
+			sysex_release();
+		}
+	}
+	f = midi_frame_swap();
+
+	CHECK_EQ(got, 4);
+	CHECK_EQ(lens[0], 6);
+	CHECK(!memcmp(msgs[0], "\xF0\x7D\x45\x02\x05\xF7", 6));
+	CHECK_EQ(flags_seen[0], 0);
+	CHECK_EQ(lens[1], 9);    // the clock isn't part of it
+	CHECK(!memcmp(msgs[1], "\xF0\x43\x10\x4C\x00\x00\x7E\x00\xF7", 9));
+	CHECK_EQ(lens[2], 6);
+	CHECK(!memcmp(msgs[2], "\xF0\x41\x10\x42\x12\xF7", 6));
+	CHECK_EQ(flags_seen[2], SYSEX_UNTERMINATED);
+	CHECK_EQ(lens[3], 6);
+	CHECK_EQ(f->event_count, 1);
+	CHECK(event_is(f, 0, 0x90, 0x3C, 0x64));
+	CHECK(note_on(f, 0x3C));
+
+	// too long, the end is cut off but the F7 stays
+	reset(0xFFFF, 0);
+	recvByte(0xF0);
+	for (i = 0; i < 200; i++) recvByte(i & 0x7F);
+	recvByte(0xF7);
+	len = sysex_get(&m, &flags, &lost);
+	CHECK_EQ(len, SYSEX_MAX);
+	CHECK_EQ(flags, SYSEX_TRUNCATED);
+	CHECK_EQ(m[SYSEX_MAX - 1], 0xF7);
+	CHECK_EQ(m[SYSEX_MAX - 2], (SYSEX_MAX - 3) & 0x7F);
+	sysex_release();
+
+	// a second one done before the first is picked up is dropped and counted
+	recvByte(0xF0); recvByte(0x01); recvByte(0xF7);
+	recvByte(0xF0); recvByte(0x02); recvByte(0xF7);
+	len = sysex_get(&m, &flags, &lost);
+	CHECK_EQ(len, 3);
+	CHECK_EQ(m[1], 0x01);
+	CHECK_EQ(lost, 1);
+	CHECK_EQ(host_irq_disabled, 0);
+	sysex_release();
+	CHECK_EQ(sysex_get(&m, &flags, &lost), 0);
+
+	// the count is read and reset in one go, the next one starts from 0
+	recvByte(0xF0); recvByte(0x03); recvByte(0xF7);
+	len = sysex_get(&m, &flags, &lost);
+	CHECK_EQ(lost, 0);
+	sysex_release();
+	CHECK_EQ(sysex_get(&m, &flags, &lost), 0);
+}
+
+static void test_channel_mask(void) {
+	uint8_t s[STREAM_MAX];
+	int n = load("channel_mask.hex", s);
+	midi_frame_t * f;
+	static const uint8_t thru_masked[] = {
+		0x90, 0x30, 0x40, 0x99, 0x24, 0x7F, 0xB9, 0x15, 0x22, 0xC0, 0x05,
+	};
+
+	// channels 1 and 10
+	reset(0x0201, MIDI_THRU_VOICE);
+	feed(s, n);
+	f = midi_frame_swap();
+
+	CHECK_EQ(f->event_count, 4);
+	CHECK(event_is(f, 0, 0x90, 0x30, 0x40));
+	CHECK(event_is(f, 1, 0x99, 0x24, 0x7F));
+	CHECK(event_is(f, 2, 0xB9, 0x15, 0x22));
+	CHECK(event_is(f, 3, 0xC0, 0x05, 0));
+	CHECK(note_on(f, 0x30) && note_on(f, 0x24) && !note_on(f, 0x31));
+	CHECK_EQ(f->blob[16], 0x22);
+	CHECK_EQ(f->blob[22], 0x05);
+	CHECK_EQ(midi_velocity[0x31], 0);
+	CHECK_EQ(host_uart1_out_len, sizeof(thru_masked));
+	CHECK(!memcmp(host_uart1_out, thru_masked, sizeof(thru_masked)));
+
+	// every channel, and thru regardless of the mask
+	reset(0xFFFF, MIDI_THRU_VOICE | MIDI_THRU_ALL_CHANNELS);
+	feed(s, n);
+	f = midi_frame_swap();
+	CHECK_EQ(f->event_count, 8);
+	CHECK(note_on(f, 0x30) && note_on(f, 0x24) && !note_on(f, 0x31));   // ch 2 note went off again
+	CHECK_EQ(f->blob[22], 0x06);
+	CHECK_EQ(host_uart1_out_len, n);   // nothing to shorten, every status is different
+
+	// just channel 2, listed as the one to send on
+	reset(0x0002, 0);
+	feed(s, n);
+	f = midi_frame_swap();
+	CHECK_EQ(f->event_count, 4);
+	CHECK_EQ(channelIn_, 2);
+}
+
+int main(void) {
+	test_running_status();
+	test_realtime();
+	test_sysex();
+	test_channel_mask();
+	return check_report("test_midi");
+}
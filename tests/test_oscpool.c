@@ -0,0 +1,124 @@
+/*
+ * test_oscpool.c
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+// random alloc / realloc / free against the OSC pools, built with ASan.  every
+// block is filled with its own pattern, checked before it is freed and after
+// every realloc (up to the smaller of the two sizes), so a block handed out
+// twice or copied short shows up as a wrong byte, one written past as an ASan report
+
+#include <stdlib.h>
+#include <string.h>
+#include "host.h"
+#include "OSCPool.h"
+
+#define SLOTS 96
+#define ROUNDS 200000
+#define SIZE_MAX_TRY 400    // past the large class, so malloc gets some
+
+static uint8_t * slot[SLOTS];
+static size_t slot_size[SLOTS];
+static uint8_t slot_tag[SLOTS];
+
+static uint32_t seed = 7;
+
+static uint32_t rnd(uint32_t n) {
+	seed = seed * 1103515245 + 12345;
+	return (seed >> 8) % n;
+}
+
+static void fill(int i) {
+	size_t j;
+	for (j = 0; j < slot_size[i]; j++) slot[i][j] = slot_tag[i] + j;
+}
+
+static int intact(int i, size_t size) {
+	size_t j;
+	for (j = 0; j < size; j++) if (slot[i][j] != (uint8_t) (slot_tag[i] + j)) return 0;
+	return 1;
+}
+
+static uint32_t pool_live(void) {
+	osc_pool_stats_t s;
+	uint32_t n = 0;
+	uint8_t i;
+	for (i = 0; i < OSC_POOL_CLASSES; i++) {
+		osc_pool_stats(i, &s);
+		CHECK(s.live <= s.count);
+		CHECK(s.peak <= s.count);
+		n += s.live;
+	}
+	return n;
+}
+
+int main(void) {
+	uint32_t round;
+	int i, used = 0;
+	size_t size;
+	osc_pool_stats_t s;
+
+	for (round = 0; round < ROUNDS; round++) {
+		i = rnd(SLOTS);
+		// mostly small ones, like OSCData and addresses
+		size = rnd(4) ? 1 + rnd(OSC_POOL_SMALL_SIZE) : 1 + rnd(SIZE_MAX_TRY);
+
+		if (!slot[i]) {
+			slot[i] = osc_pool_alloc(size);
+			CHECK(slot[i] != 0);
+			CHECK(((uintptr_t) slot[i] & 7) == 0);
+			slot_size[i] = size;
+			slot_tag[i] = rnd(256);
+			fill(i);
+			used++;
+		} else if (rnd(2)) {
+			size_t keep = (size < slot_size[i]) ? size : slot_size[i];
+			uint8_t * p = osc_pool_realloc(slot[i], size);
+			CHECK(p != 0);
+			CHECK(((uintptr_t) p & 7) == 0);
+			slot[i] = p;
+			if (!intact(i, keep)) {
+				printf("round %u: realloc of slot %d to %u lost data\n", round, i, (unsigned) size);
+				check_failures++;
+			}
+			slot_size[i] = size;
+			fill(i);
+		} else {
+			if (!intact(i, slot_size[i])) {
+				printf("round %u: slot %d overwritten\n", round, i);
+				check_failures++;
+			}
+			osc_pool_free(slot[i]);
+			slot[i] = 0;
+			used--;
+		}
+		if (check_failures > 10) break;
+	}
+
+	CHECK(pool_live() <= used);
+	for (i = 0; i < SLOTS; i++) {
+		if (!slot[i]) continue;
+		CHECK(intact(i, slot_size[i]));
+		osc_pool_free(slot[i]);
+	}
+	CHECK_EQ(pool_live(), 0);
+	CHECK(osc_pool_fallbacks() > 0);    // the big ones and the overflow went to malloc
+	CHECK_EQ(osc_pool_failures(), 0);
+
+	// every block of a class can be out at once, the next one spills into the class above
+	{
+		void * p[OSC_POOL_SMALL_COUNT + 1];
+		uint32_t fallbacks = osc_pool_fallbacks();
+		for (i = 0; i <= OSC_POOL_SMALL_COUNT; i++) p[i] = osc_pool_alloc(OSC_POOL_SMALL_SIZE);
+		osc_pool_stats(0, &s);
+		CHECK_EQ(s.live, OSC_POOL_SMALL_COUNT);
+		osc_pool_stats(1, &s);
+		CHECK_EQ(s.live, 1);
+		CHECK_EQ(osc_pool_fallbacks(), fallbacks);
+		for (i = 0; i <= OSC_POOL_SMALL_COUNT; i++) osc_pool_free(p[i]);
+	}
+	CHECK_EQ(pool_live(), 0);
+
+	return check_report("test_oscpool");
+}
@@ -0,0 +1,141 @@
+/*
+ * test_sched.c
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+// the /at queue: time order, first in first out for the same time, slots
+// coming back after release, and what gets turned away
+
+#include <string.h>
+#include "host.h"
+#include "sched.h"
+
+static sched_stats_t st;
+
+static uint8_t add(uint64_t at, uint64_t now, const char * msg) {
+	return sched_add(at, now, (const uint8_t *) msg, strlen(msg) + 1);
+}
+
+// the next one due by /now/ has to be /msg/
+static void next(uint64_t now, const char * msg) {
+	uint8_t * m;
+	uint8_t len = sched_get(now, &m);
+
+	CHECK_EQ(len, strlen(msg) + 1);
+	if (len == strlen(msg) + 1) CHECK(!memcmp(m, msg, len));
+	sched_release();
+}
+
+static void test_order(void) {
+	uint8_t * m;
+
+	sched_clear();
+	CHECK(add(100, 0, "/a"));
+	CHECK(add(50, 0, "/b"));
+	CHECK(add(100, 0, "/c"));
+	CHECK(add(100, 0, "/d"));
+	CHECK(add(50, 0, "/e"));
+	CHECK(add(75, 0, "/f"));
+	CHECK_EQ(sched_pending(), 6);
+
+	// nothing before its time
+	CHECK_EQ(sched_get(49, &m), 0);
+
+	// same time goes in the order they came
+	next(50, "/b");
+	next(50, "/e");
+	CHECK_EQ(sched_get(74, &m), 0);
+	next(1000, "/f");
+	next(1000, "/a");
+	next(1000, "/c");
+	next(1000, "/d");
+	CHECK_EQ(sched_pending(), 0);
+	CHECK_EQ(sched_get(1000, &m), 0);
+}
+
+static void test_slots(void) {
+	char msg[16];
+	int i, round, in = 0, out = 0;
+
+	// release and add over and over, the messages must stay whole
+	sched_clear();
+	for (round = 0; round < 20; round++) {
+		while (sched_pending() < SCHED_SLOTS) {
+			snprintf(msg, sizeof(msg), "/%d", in);
+			CHECK(add(1000 + in, 0, msg));
+			in++;
+		}
+		for (i = 0; i < 3; i++) {
+			snprintf(msg, sizeof(msg), "/%d", out++);
+			next(1000000, msg);
+		}
+	}
+}
+
+static void test_turned_away(void) {
+	uint8_t big[SCHED_MSG_MAX + 1];
+	uint8_t * m;
+	int i;
+
+	sched_clear();
+	sched_stats(&st);
+	CHECK_EQ(st.queued, 0);
+
+	memset(big, 'x', sizeof(big));
+	big[0] = '/';
+	CHECK(!sched_add(100, 0, big, 0));
+	CHECK(!sched_add(100, 0, big, SCHED_MSG_MAX + 1));
+	CHECK(sched_add(100, 0, big, SCHED_MSG_MAX));
+
+	for (i = 1; i < SCHED_SLOTS; i++) CHECK(add(100 + i, 0, "/x"));
+	CHECK(!add(50, 0, "/y"));
+	sched_stats(&st);
+	CHECK_EQ(st.full, 1);
+	CHECK_EQ(st.queued, SCHED_SLOTS);
+	CHECK_EQ(st.peak, SCHED_SLOTS);
+
+	CHECK_EQ(sched_get(100, &m), SCHED_MSG_MAX);
+	CHECK(!memcmp(m, big, SCHED_MSG_MAX));
+	sched_release();
+	sched_clear();
+	CHECK_EQ(sched_pending(), 0);
+}
+
+static void test_stats(void) {
+	sched_stats_t before;
+
+	sched_clear();
+	sched_stats(&before);
+
+	// already due when it came in
+	CHECK(add(1000, 1000, "/now"));
+	CHECK(add(900, 1000, "/past"));
+	CHECK(add(5000, 1000, "/later"));
+	sched_stats(&st);
+	CHECK_EQ(st.past, before.past + 2);
+
+	next(1000, "/past");
+	next(1000, "/now");
+	next(5500, "/later");
+	sched_stats(&st);
+	CHECK_EQ(st.run, before.run + 3);
+	CHECK(st.late_max >= 500);
+	CHECK(st.late_avg <= st.late_max);
+
+	// a lot later doesn't go into the average
+	CHECK(add(0, 0, "/old"));
+	sched_stats(&before);
+	next(5000000, "/old");
+	sched_stats(&st);
+	CHECK_EQ(st.late_max, 5000000);
+	CHECK_EQ(st.late_avg, before.late_avg);
+}
+
+int main(void) {
+	test_order();
+	test_slots();
+	test_turned_away();
+	test_stats();
+	return check_report("test_sched");
+}
@@ -0,0 +1,126 @@
+/*
+ * test_slip.cpp
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+// SLIP framing both ways: sendMessage encodes straight into the port and
+// recvMessage decodes as it takes bytes off the rx ring
+
+#include <string.h>
+#include "SLIPEncodedSerial.h"
+
+extern "C" {
+#include "host.h"
+#include "uart.h"
+}
+
+// the host port, the ring the USART2 ISR fills and what goes out
+uint8_t uart2_recv_buf[UART2_BUFFER_SIZE];
+uint16_t uart2_recv_buf_head = 0;
+uint16_t uart2_recv_buf_tail = 0;
+volatile uint32_t uart2_eot_micros = 0;
+
+static uint8_t sent[1024];
+static int sent_len = 0;
+
+void uart2_send(uint8_t c) {
+	if (sent_len < (int) sizeof(sent)) sent[sent_len++] = c;
+}
+
+static void arrive(const uint8_t * bytes, int len) {
+	while (len--) {
+		uart2_recv_buf[uart2_recv_buf_head] = *bytes++;
+		uart2_recv_buf_head = (uart2_recv_buf_head + 1) % UART2_BUFFER_SIZE;
+	}
+}
+
+// encode with sendMessage and feed that back in a piece at a time
+static int round_trip(SLIPEncodedSerial & slip, const uint8_t * msg, int len) {
+	int i, got = 0;
+
+	sent_len = 0;
+	CHECK_EQ(slip.sendMessage(msg, len), sent_len);
+	for (i = 0; i < sent_len; i += 100) {
+		arrive(&sent[i], ((sent_len - i) < 100) ? (sent_len - i) : 100);
+		got = slip.recvMessage();
+		if (got) break;
+	}
+	return got && (i + 100 >= sent_len) && (slip.decodedLength == (uint32_t) len)
+			&& !memcmp(slip.decodedBuf, msg, len);
+}
+
+int main(void) {
+	SLIPEncodedSerial slip;
+	static const uint8_t special[] = { 1, 0300, 2, 0333, 3 };
+	static const uint8_t special_out[] = { 0300, 1, 0333, 0334, 2, 0333, 0335, 3, 0300 };
+	static const uint8_t gaps[] = { 0300, 0300, 'a', 'b', 0300, 0300, 'c', 0300 };
+	static const uint8_t bad_escape[] = { 'a', 0333, 'x', 'b', 0300 };
+	static const uint8_t split_a[] = { 0300, 'h', 'e', 0333 };
+	static const uint8_t split_b[] = { 0334, 'y', 0300 };
+	uint8_t msg[MAX_MSG_SIZE];
+	uint8_t big[MAX_MSG_SIZE + 50];
+	int i;
+
+	// END, escapes for END and ESC, END
+	sent_len = 0;
+	CHECK_EQ(slip.sendMessage(special, sizeof(special)), sizeof(special_out));
+	CHECK_EQ(sent_len, sizeof(special_out));
+	CHECK(!memcmp(sent, special_out, sizeof(special_out)));
+
+	// everything a byte can be, and the longest message when half of it is escaped
+	for (i = 0; i < MAX_MSG_SIZE; i++) msg[i] = i;
+	CHECK(round_trip(slip, msg, MAX_MSG_SIZE));
+	for (i = 0; i < MAX_MSG_SIZE; i++) msg[i] = (i & 1) ? 0300 : 0333;
+	CHECK(round_trip(slip, msg, MAX_MSG_SIZE));
+
+	// ENDs between messages are gaps, each message comes out on its own
+	arrive(gaps, sizeof(gaps));
+	CHECK_EQ(slip.recvMessage(), 1);
+	CHECK_EQ(slip.decodedLength, 2);
+	CHECK(!memcmp(slip.decodedBuf, "ab", 2));
+	CHECK_EQ(slip.recvMessage(), 1);
+	CHECK_EQ(slip.decodedLength, 1);
+	CHECK(slip.decodedBuf[0] == 'c');
+	CHECK_EQ(slip.recvMessage(), 0);
+
+	// an escape split over two passes
+	arrive(split_a, sizeof(split_a));
+	CHECK_EQ(slip.recvMessage(), 0);
+	arrive(split_b, sizeof(split_b));
+	CHECK_EQ(slip.recvMessage(), 1);
+	CHECK_EQ(slip.decodedLength, 4);
+	CHECK(!memcmp(slip.decodedBuf, "he\300y", 4));
+
+	// an escape that isn't one drops both bytes
+	arrive(bad_escape, sizeof(bad_escape));
+	CHECK_EQ(slip.recvMessage(), 1);
+	CHECK_EQ(slip.decodedLength, 2);
+	CHECK(!memcmp(slip.decodedBuf, "ab", 2));
+
+	// too long is dropped whole, its tail doesn't turn into a message, the next one is fine
+	memset(big, 'z', sizeof(big));
+	big[sizeof(big) - 1] = 0300;
+	arrive(big, 150);
+	CHECK_EQ(slip.recvMessage(), 0);
+	arrive(&big[150], sizeof(big) - 150);
+	CHECK_EQ(slip.recvMessage(), 0);
+	arrive(gaps, 5);
+	CHECK_EQ(slip.recvMessage(), 1);
+	CHECK_EQ(slip.decodedLength, 2);
+
+	// the ISR's END stamp when nothing is behind the message, now when something is
+	host_micros = 5000;
+	uart2_eot_micros = 1234;
+	arrive(&gaps[2], 3);
+	CHECK_EQ(slip.recvMessage(), 1);
+	CHECK_EQ(slip.rxMicros, 1234);
+	arrive(&gaps[2], 3);
+	arrive(&gaps[6], 2);
+	CHECK_EQ(slip.recvMessage(), 1);
+	CHECK_EQ(slip.rxMicros, 5000);
+	CHECK_EQ(slip.recvMessage(), 1);
+	CHECK_EQ(slip.rxMicros, 1234);
+
+	return check_report("test_slip");
+}
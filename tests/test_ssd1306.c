@@ -0,0 +1,284 @@
+/*
+ * test_ssd1306.c
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+// text through put_column has to leave pix_buf (and the dirty ranges) exactly
+// as the old per pixel drawing did, wrap at the right and bottom edges included.
+// then the RLE / XOR unpacking (/oled/rle, /oled/xor) and fill_rect clipping
+
+#include <stdlib.h>
+#include <string.h>
+#include "host.h"
+#include "ssd1306.c"
+#include "ssd1306_old.h"
+
+static uint8_t start_buf[1024];
+static uint8_t old_buf[1024], old_lo[8], old_hi[8];
+
+static uint32_t seed = 1;
+
+static uint8_t rnd(void) {
+	seed = seed * 1103515245 + 12345;
+	return seed >> 16;
+}
+
+// each case starts from the same noisy screen, so cleared pixels count too
+static void start(void) {
+	memcpy(pix_buf, start_buf, sizeof(pix_buf));
+	memset(dirty_lo, 0xFF, sizeof(dirty_lo));
+	memset(dirty_hi, 0, sizeof(dirty_hi));
+}
+
+static void save_old(void) {
+	memcpy(old_buf, pix_buf, sizeof(pix_buf));
+	memcpy(old_lo, dirty_lo, sizeof(dirty_lo));
+	memcpy(old_hi, dirty_hi, sizeof(dirty_hi));
+}
+
+static int same(const char * what) {
+	if (!memcmp(old_buf, pix_buf, sizeof(pix_buf)) && !memcmp(old_lo, dirty_lo, sizeof(dirty_lo))
+			&& !memcmp(old_hi, dirty_hi, sizeof(dirty_hi))) return 1;
+	printf("%s: differs from the per pixel path\n", what);
+	return 0;
+}
+
+static void small_at(char * s, int len, int x, int y) {
+	start();
+	old_println_8(s, len, x, y);
+	save_old();
+	start();
+	println_8(s, len, x, y);
+}
+
+static void arial_at(char * s, int len, int x, int y) {
+	start();
+	old_println_16(s, len, x, y);
+	save_old();
+	start();
+	println_16(s, len, x, y);
+}
+
+// blank screen, nothing dirty
+static void blank(void) {
+	memset(pix_buf, 0, sizeof(pix_buf));
+	memset(dirty_lo, 0xFF, sizeof(dirty_lo));
+	memset(dirty_hi, 0, sizeof(dirty_hi));
+}
+
+// the noisy screen with nothing dirty
+static void noisy(void) {
+	start();
+	memset(dirty_lo, 0xFF, sizeof(dirty_lo));
+}
+
+// bytes from offset on are all b
+static int run_of(int offset, int n, uint8_t b) {
+	for (; n; n--, offset++) if (pix_buf[offset] != b) return 0;
+	return 1;
+}
+
+// pages other than the ones listed have nothing dirty
+static int clean_except(int page_a, int page_b) {
+	int page;
+
+	for (page = 0; page < 8; page++) {
+		if ((page == page_a) || (page == page_b)) continue;
+		if ((dirty_lo[page] != 0xFF) || (dirty_hi[page] != 0)) return 0;
+	}
+	return 1;
+}
+
+static void rle_cases(void) {
+	// a literal of 3, then a repeat of 5 (130 - 125), in the middle of page 1
+	static const uint8_t mixed[] = { 2, 0x11, 0x22, 0x33, 130, 0x44 };
+	// longest of each: 128 literal bytes, 130 repeats
+	static uint8_t longest[1 + 128 + 2];
+	static const uint8_t cut_literal[] = { 1, 0xAA, 0xBB, 2, 0xCC };
+	static const uint8_t cut_repeat[] = { 1, 0xAA, 0xBB, 200 };
+	static const uint8_t tail_repeat[] = { 255, 0x5A };
+	static const uint8_t tail_literal[] = { 3, 1, 2, 3, 4 };
+	static const uint8_t zeros[] = { 255, 0, 255, 0, 1, 0, 0 };
+	static const uint8_t one_flip[] = { 2, 0x00, 0xFF, 0x00 };
+	int i;
+
+	blank();
+	CHECK_EQ(ssd1306_put_rle(130, mixed, sizeof(mixed), 0), 8);
+	CHECK(pix_buf[129] == 0);
+	CHECK(pix_buf[130] == 0x11);
+	CHECK(pix_buf[131] == 0x22);
+	CHECK(pix_buf[132] == 0x33);
+	CHECK(run_of(133, 5, 0x44));
+	CHECK(pix_buf[138] == 0);
+	CHECK_EQ(dirty_lo[1], 2);
+	CHECK_EQ(dirty_hi[1], 9);
+	CHECK(clean_except(1, 1));
+
+	// across the page 0 / page 1 boundary
+	longest[0] = 127;
+	for (i = 0; i < 128; i++) longest[1 + i] = i + 1;
+	longest[129] = 255;
+	longest[130] = 0x77;
+	blank();
+	CHECK_EQ(ssd1306_put_rle(64, longest, sizeof(longest), 0), 258);
+	for (i = 0; i < 128; i++) CHECK(pix_buf[64 + i] == i + 1);
+	CHECK(run_of(192, 130, 0x77));
+	CHECK(pix_buf[322] == 0);
+	CHECK_EQ(dirty_lo[0], 64);
+	CHECK_EQ(dirty_hi[0], 127);
+	CHECK_EQ(dirty_lo[1], 0);
+	CHECK_EQ(dirty_hi[1], 127);
+	CHECK_EQ(dirty_lo[2], 0);
+	CHECK_EQ(dirty_hi[2], 65);
+
+	// a final run with its bytes missing is dropped whole
+	blank();
+	CHECK_EQ(ssd1306_put_rle(0, cut_literal, sizeof(cut_literal), 0), 2);
+	CHECK(pix_buf[0] == 0xAA);
+	CHECK(pix_buf[1] == 0xBB);
+	CHECK(run_of(2, 3, 0));
+	blank();
+	CHECK_EQ(ssd1306_put_rle(0, cut_repeat, sizeof(cut_repeat), 0), 2);
+	CHECK(run_of(2, 5, 0));
+	CHECK_EQ(dirty_hi[0], 1);
+
+	// runs stop at the end of pix_buf, they don't wrap to the top
+	blank();
+	CHECK_EQ(ssd1306_put_rle(1020, tail_repeat, sizeof(tail_repeat), 0), 4);
+	CHECK(run_of(1020, 4, 0x5A));
+	CHECK(pix_buf[0] == 0);
+	CHECK_EQ(dirty_lo[7], 124);
+	CHECK_EQ(dirty_hi[7], 127);
+	CHECK(clean_except(7, 7));
+	blank();
+	CHECK_EQ(ssd1306_put_rle(1022, tail_literal, sizeof(tail_literal), 0), 2);
+	CHECK(pix_buf[1022] == 1);
+	CHECK(pix_buf[1023] == 2);
+	CHECK(run_of(0, 2, 0));
+	CHECK(clean_except(7, 7));
+
+	// XOR with runs of 0 changes nothing and leaves the dirty ranges as they were
+	noisy();
+	dirty_lo[1] = 5;
+	dirty_hi[1] = 6;
+	CHECK_EQ(ssd1306_put_rle(0, zeros, sizeof(zeros), 1), 262);
+	CHECK(!memcmp(pix_buf, start_buf, sizeof(pix_buf)));
+	CHECK_EQ(dirty_lo[1], 5);
+	CHECK_EQ(dirty_hi[1], 6);
+	CHECK(clean_except(1, 1));
+
+	// and only the byte that flips gets marked
+	noisy();
+	CHECK_EQ(ssd1306_put_rle(10, one_flip, sizeof(one_flip), 1), 3);
+	CHECK(pix_buf[10] == start_buf[10]);
+	CHECK(pix_buf[11] == (uint8_t) ~start_buf[11]);
+	CHECK(pix_buf[12] == start_buf[12]);
+	CHECK_EQ(dirty_lo[0], 11);
+	CHECK_EQ(dirty_hi[0], 11);
+	CHECK(clean_except(0, 0));
+}
+
+static void fill_rect_cases(void) {
+	int column;
+
+	// clipped at the right and bottom, no wrap into column 0 or page 0
+	blank();
+	ssd1306_fill_rect(120, 60, 20, 20, 1);
+	for (column = 0; column < 128; column++) {
+		CHECK(pix_buf[(7 * 128) + column] == ((column >= 120) ? 0xF0 : 0));
+		CHECK(pix_buf[column] == 0);
+	}
+	CHECK(run_of(128, 6 * 128, 0));
+	CHECK_EQ(dirty_lo[7], 120);
+	CHECK_EQ(dirty_hi[7], 127);
+	CHECK(clean_except(7, 7));
+
+	// wider than the screen from the middle, 255 + x doesn't wrap the uint8_t
+	blank();
+	ssd1306_fill_rect(100, 0, 255, 8, 1);
+	CHECK(run_of(0, 100, 0));
+	CHECK(run_of(100, 28, 0xFF));
+	CHECK(clean_except(0, 0));
+
+	// starting off screen or empty draws nothing
+	blank();
+	ssd1306_fill_rect(128, 0, 10, 10, 1);
+	ssd1306_fill_rect(0, 64, 10, 10, 1);
+	ssd1306_fill_rect(0, 0, 0, 10, 1);
+	ssd1306_fill_rect(0, 0, 10, 0, 1);
+	CHECK(run_of(0, sizeof(pix_buf), 0));
+	CHECK(clean_except(-1, -1));
+
+	// partial pages at the top and bottom of the rectangle, clearing too
+	noisy();
+	ssd1306_fill_rect(10, 3, 2, 10, 0);
+	CHECK(pix_buf[10] == (start_buf[10] & 0x07));
+	CHECK(pix_buf[11] == (start_buf[11] & 0x07));
+	CHECK(pix_buf[138] == (start_buf[138] & 0xE0));
+	CHECK(pix_buf[139] == (start_buf[139] & 0xE0));
+	CHECK(pix_buf[9] == start_buf[9]);
+	CHECK(pix_buf[12] == start_buf[12]);
+	CHECK(pix_buf[266] == start_buf[266]);
+}
+
+int main(void) {
+	char line[32];
+	int i, x, y;
+
+	for (i = 0; i < sizeof(start_buf); i++) start_buf[i] = rnd();
+	for (i = 0; i < sizeof(line); i++) line[i] = 'A' + (i % 26);
+
+	// a full screen of small text, on page boundaries and between them
+	for (y = 0; y < 8; y++) {
+		small_at(line, 22, 0, y * 8);
+		CHECK(same("small, page aligned"));
+		small_at(line, 22, 0, (y * 8) + 3);
+		CHECK(same("small, unaligned"));
+	}
+
+	// off the right edge (x wraps at 128) and off the bottom (page 7 into page 0)
+	small_at(line, 6, 110, 20);
+	CHECK(same("small, right edge"));
+	small_at(line, 6, 10, 60);
+	CHECK(same("small, bottom edge"));
+	small_at(line, 6, 120, 61);
+	CHECK(same("small, corner"));
+	for (y = 0; y < 4; y++) {
+		arial_at(line, 8, 0, y * 16);
+		CHECK(same("arial16, page aligned"));
+	}
+	arial_at(line, 8, 100, 5);
+	CHECK(same("arial16, right edge"));
+	arial_at(line, 8, 0, 52);
+	CHECK(same("arial16, bottom edge"));
+	arial_at(line, 8, 115, 57);
+	CHECK(same("arial16, corner"));
+
+	// every glyph of both fonts, anywhere, both colors for arial
+	for (i = 0; i < 3000; i++) {
+		uint8_t c = rnd();
+		x = rnd();
+		y = rnd();
+
+		start();
+		old_put_char_small(c, x, y);
+		save_old();
+		start();
+		put_char_small(c, x, y);
+		CHECK(same("random small"));
+
+		c = 32 + (c % 96);
+		start();
+		old_put_char_arial16(c, x, y, i & 1);
+		save_old();
+		start();
+		put_char_arial16(c, x, y, i & 1);
+		CHECK(same("random arial16"));
+	}
+
+	rle_cases();
+	fill_rect_cases();
+
+	return check_report("test_ssd1306");
+}
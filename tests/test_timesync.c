@@ -0,0 +1,139 @@
+/*
+ * test_timesync.c
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+// timetags to microseconds and back, a /sync exchange against a host clock
+// that is off by some amount and runs fast, and the mapping both ways
+
+#include "host.h"
+#include "timesync.h"
+
+static void test_ntp(void) {
+	uint32_t s, f;
+	uint64_t us;
+
+	timesync_to_ntp(0, &s, &f);
+	CHECK_EQ(s, 0);
+	CHECK_EQ(f, 0);
+	timesync_to_ntp(500000, &s, &f);
+	CHECK_EQ(s, 0);
+	CHECK_EQ(f, 0x80000000);
+	timesync_to_ntp(1000000, &s, &f);
+	CHECK_EQ(s, 1);
+	CHECK_EQ(f, 0);
+	timesync_to_ntp(999999, &s, &f);
+	CHECK_EQ(s, 0);
+	CHECK(f > 0xFFFFE000);
+	CHECK_EQ(timesync_from_ntp(0, 0xFFFFFFFF), 1000000);
+
+	// every microsecond of a second, then far out, comes back the same
+	for (us = 0; us < 1000000; us++) {
+		timesync_to_ntp(us, &s, &f);
+		if (timesync_from_ntp(s, f) != us) {
+			CHECK_EQ(timesync_from_ntp(s, f), us);
+			break;
+		}
+	}
+	for (us = 0xFFFFFFFFULL * 1000000ULL; us < (0xFFFFFFFFULL * 1000000ULL) + 1000000; us += 7919) {
+		timesync_to_ntp(us, &s, &f);
+		CHECK_EQ(s, 0xFFFFFFFF);
+		if (timesync_from_ntp(s, f) != us) {
+			CHECK_EQ(timesync_from_ntp(s, f), us);
+			break;
+		}
+	}
+}
+
+// the host clock, it started /offset/ us before the controller and runs /ppb/ fast
+static int64_t host_offset = 3600000000LL + 123457;
+static int64_t host_ppb = 40000;    // 40 ppm
+
+static uint64_t host_clock(uint64_t ctrl) {
+	return ctrl + host_offset + (((int64_t) ctrl * host_ppb) / 1000000000LL);
+}
+
+// one /sync: t1 host send, t2 controller in, t3 controller out, t4 host in.
+// the times go over as timetags, the host works out the controller time at its t1
+static void sync(uint64_t ctrl, uint32_t up, uint32_t down, uint64_t * at_ctrl, uint64_t * at_host) {
+	uint64_t t1 = host_clock(ctrl);
+	uint32_t s2, f2, s3, f3;
+	int64_t offset;
+
+	timesync_to_ntp(ctrl + up, &s2, &f2);
+	timesync_to_ntp(ctrl + up + 50, &s3, &f3);
+
+	uint64_t t2 = timesync_from_ntp(s2, f2);
+	uint64_t t3 = timesync_from_ntp(s3, f3);
+	uint64_t t4 = host_clock(ctrl + up + 50 + down);
+
+	// offset = ((t2 - t1) + (t3 - t4)) / 2, controller minus host
+	offset = (((int64_t) (t2 - t1)) + ((int64_t) (t3 - t4))) / 2;
+	*at_host = t1;
+	*at_ctrl = t1 + offset;
+}
+
+static void test_sync(void) {
+	uint64_t ctrl0, host0, ctrl1, host1, c, h;
+	int64_t drift, err;
+
+	CHECK(!timesync_valid());
+	CHECK_EQ(timesync_host_micros(12345), 12345);
+	CHECK_EQ(timesync_ctrl_micros(12345), 12345);
+
+	// the same path both ways, the offset comes out to the microsecond
+	sync(1000000, 700, 700, &ctrl0, &host0);
+	err = (int64_t) (host_clock(ctrl0) - host0);
+	CHECK(err >= -1 && err <= 1);
+
+	// ten minutes later the offset has moved by the drift
+	sync(601000000, 700, 700, &ctrl1, &host1);
+	drift = ((((int64_t) (host1 - ctrl1)) - ((int64_t) (host0 - ctrl0))) * 1000000000LL) / (int64_t) (ctrl1 - ctrl0);
+	CHECK(drift >= host_ppb - 10 && drift <= host_ppb + 10);
+
+	timesync_set(ctrl1, host1, drift);
+	CHECK(timesync_valid());
+
+	// host time from controller time, an hour either side
+	for (c = ctrl1 - 3600000000ULL; c < ctrl1 + 3600000000ULL; c += 60000000) {
+		err = (int64_t) (timesync_host_micros(c) - host_clock(c));
+		if (err < -2 || err > 2) {
+			CHECK_EQ(err, 0);
+			break;
+		}
+	}
+
+	// and back, within the two roundings
+	for (h = host1; h < host1 + 3600000000ULL; h += 60000007) {
+		err = (int64_t) (timesync_host_micros(timesync_ctrl_micros(h)) - h);
+		if (err < -1 || err > 1) {
+			CHECK_EQ(err, 0);
+			break;
+		}
+	}
+
+	// a lopsided path puts half the difference into the offset
+	sync(1000000, 300, 1300, &ctrl0, &host0);
+	err = (int64_t) (host_clock(ctrl0) - host0);
+	CHECK(err >= -501 && err <= -499);
+
+	// drift is clamped, and at the clamp an hour out still maps back
+	timesync_set(0, 0, 50000000);
+	CHECK_EQ(timesync_host_micros(1000000000), 1000000000 + 1000000);
+	timesync_set(0, 0, -50000000);
+	CHECK_EQ(timesync_host_micros(1000000000), 1000000000 - 1000000);
+	for (h = 0; h < 3600000000ULL; h += 60000007) {
+		err = (int64_t) (timesync_host_micros(timesync_ctrl_micros(h)) - h);
+		if (err < -1 || err > 1) {
+			CHECK_EQ(err, 0);
+			break;
+		}
+	}
+}
+
+int main(void) {
+	test_ntp();
+	test_sync();
+	return check_report("test_timesync");
+}